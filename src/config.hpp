@@ -1,4 +1,7 @@
 #pragma once
+#include "lattice.hpp"
+#include "recode.hpp"
+#include "hierarchy.hpp"
 
 #define FIELD_PATH_PROJ 	"path.dir_project"
 #define FIELD_PATH_OUTP 	"path.dir_output"
@@ -11,10 +14,37 @@
 #define FIELD_SIZE      	"size"
 #define FIELD_BEGIN      	"begin"
 
+#define FIELD_THREADS      	"aggregation.threads"
+#define FIELD_MODE         	"aggregation.mode"
+#define FIELD_SPECIALIZE   	"aggregation.specialize"
+#define FIELD_STATE        	"aggregation.state"
+#define FIELD_SPARSE       	"aggregation.sparse"
+#define FIELD_SORT         	"aggregation.sort"
+#define FIELD_CELLS        	"aggregation.cells"
+
+#define MODE_MAP           	"map"
+#define MODE_RADIX         	"radix"
+
+#define CELLS_WIDE         	"wide"
+#define CELLS_COMPACT      	"compact"
+
+#define FIELD_MARGINALS    	"marginals"
+#define ELEM_MAXORDER      	"max_order"
+#define ELEM_LIST          	"list"
+
+#define FIELD_TABLES       	"tables"
+#define ELEM_FIELDS        	"fields"
+
+#define FIELD_MAGNITUDE    	"magnitude.field"
+
 #define FIELD_PRNG      	"prng.engine"
 #define FIELD_SEED      	"prng.seed"
 #define FIELD_TEST      	"prng.test"
 
+#define ENGINE_MT       	"mersennetwister"
+#define ENGINE_PHILOX   	"philox"
+#define ENGINE_XOSHIRO  	"xoshiro256"
+
 #define FIELD_DPFMU     	"noise.DPF_mu"
 #define FIELD_DPFB      	"noise.DPF_b"
 #define FIELD_DPGEPS    	"noise.DPG_eps"
@@ -22,10 +52,28 @@
 #define FIELD_CKD       	"noise.CK_D"
 #define FIELD_CKVAR     	"noise.CK_var"
 #define FIELD_CKjs      	"noise.CK_js"
+#define FIELD_CKRKEY    	"noise.CK_rkey"
+#define FIELD_CKPTABLE  	"noise.CK_ptable"
+#define FIELD_MECHANISMS	"noise.mechanisms"
+
+#define RKEY_ENGINE     	"engine"
+#define RKEY_FIXED      	"fixed"
+
+#define PTABLE_NATIVE   	"native"
+#define PTABLE_R        	"R"
 
 #define FIELD_EXP       	"micro"
+#define ELEM_NAME       	"name"
 #define ELEM_TYPE       	"type"
 #define ELEM_CUBE       	"cube"
+#define ELEM_RECODE     	"recode"
+#define ELEM_BINS       	"bins"
+#define ELEM_MAP        	"map"
+#define ELEM_OTHER      	"other"
+#define ELEM_TRUNCATE   	"truncate"
+#define ELEM_HIERARCHY  	"hierarchy"
+#define ELEM_LEVELS     	"levels"
+#define ELEM_FILE       	"file"
 
 namespace confly
 {
@@ -66,6 +114,8 @@ namespace confly
 	/// - metadata of the microdata set (field names,
 	///   types and flags indicating whether to aggregate
 	///   only)
+	/// - marginal tables to materialize in the 
+	///   hypercubes (optional)
 	/// @note Have a quick glance to the "config.json" file 
 	/// published in the Git repository.  
 	struct config
@@ -83,6 +133,13 @@ namespace confly
 			, _Rate(1.0)    // sampling rate
 			, _Cubes(1)     // number of cubes
 			, _Begin(0)     // 1st cube starting#
+			, _Threads(0)   // threads per cube
+			, _Mode(MODE_MAP) // aggregation mode
+			, _BSpecialize(false) // shape plugin
+			, _BState(false) // delta runs
+			, _BSparse(false) // support only
+			, _BSort(false)  // records by cell
+			, _Cells(CELLS_WIDE) // cell layout
 
 			, _PrngEng()    // name of rand engine
 			, _PrngSeed(42) // seed
@@ -95,11 +152,20 @@ namespace confly
 			, _CKD(3.0)
 			, _CKvar(8.0)
 			, _CKjs(1.0)
+			, _CKrkey(RKEY_ENGINE)
+			, _CKptable(PTABLE_NATIVE)
+			, _Mechanisms(MECH_ALL)
 
 			, _Size(0)      // tuple size
 			, _Types()      // cs tuple types
 			, _TypeCode()   // type code 
 			, _Mask(0)      // aggregate only mask
+			, _Names()      // field names
+			, _Lattice()    // marginals
+			, _Tables()     // output tables
+			, _Magnitude(0) // summed field
+			, _Recodes()    // derived fields
+			, _Hierarchies() // roll-ups
 		{
 			// mask: 
 			// 1-bit for including the
@@ -169,8 +235,109 @@ namespace confly
 				_Begin=_PT.get<int>(
 					FIELD_BEGIN);
 
+				// optional, 0=automatic
+				_Threads=_PT.get<size_t>(
+					FIELD_THREADS, 0);
+
+				// optional, nested maps
+				// unless "radix"
+				_Mode=_PT.get<std::string>(
+					FIELD_MODE, MODE_MAP);
+
+				if (_Mode!=MODE_MAP && 
+					_Mode!=MODE_RADIX)
+				{
+					flush_msg(std::cout,
+						M_ERROR,
+						M_PARSE,
+						M_CONF,
+						FIELD_MODE,
+						_Mode);
+
+					return false;
+				}
+
+				// optional, radix only
+				_BSpecialize=_PT.get<bool>(
+					FIELD_SPECIALIZE, false);
+
+				// optional, map only
+				_BState=_PT.get<bool>(
+					FIELD_STATE, false);
+
+				if (_BState && is_radix())
+				{
+					flush_msg(std::cout,
+						M_ERROR,
+						M_PARSE,
+						M_CONF,
+						FIELD_STATE,
+						FIELD_MODE,
+						_Mode);
+
+					return false;
+				}
+
+				// optional, map only
+				_BSparse=_PT.get<bool>(
+					FIELD_SPARSE, false);
+
+				if (_BSparse && is_radix())
+				{
+					flush_msg(std::cout,
+						M_ERROR,
+						M_PARSE,
+						M_CONF,
+						FIELD_SPARSE,
+						FIELD_MODE,
+						_Mode);
+
+					return false;
+				}
+
+				// optional
+				_BSort=_PT.get<bool>(
+					FIELD_SORT, false);
+
+				// optional, "compact" needs
+				// fixed-point record keys
+				// (checked with them)
+				_Cells=_PT.get<std::string>(
+					FIELD_CELLS, CELLS_WIDE);
+
+				if (_Cells!=CELLS_WIDE && 
+					_Cells!=CELLS_COMPACT)
+				{
+					flush_msg(std::cout,
+						M_ERROR,
+						M_PARSE,
+						M_CONF,
+						FIELD_CELLS,
+						_Cells);
+
+					return false;
+				}
+
+				// the engine of the streams
+				// of the cubes: Philox unless
+				// "xoshiro256" (the record keys
+				// are drawn by the twister)
 				_PrngEng=_PT.get<std::string>(
 					FIELD_PRNG);
+
+				if (_PrngEng!=ENGINE_MT &&
+					_PrngEng!=ENGINE_PHILOX &&
+					_PrngEng!=ENGINE_XOSHIRO)
+				{
+					flush_msg(std::cout,
+						M_ERROR,
+						M_PARSE,
+						M_CONF,
+						FIELD_PRNG,
+						_PrngEng);
+
+					return false;
+				}
 				_PrngSeed=_PT.get<size_t>(
 					FIELD_SEED);
 				_PrngTest=_PT.get<size_t>(
@@ -190,11 +357,85 @@ namespace confly
 				_CKjs=_PT.get<double>(
 					FIELD_CKjs);
 
+				// optional, record keys
+				// in the engine's range
+				// unless "fixed"
+				_CKrkey=_PT.get<std::string>(
+					FIELD_CKRKEY, RKEY_ENGINE);
+
+				if (_CKrkey!=RKEY_ENGINE && 
+					_CKrkey!=RKEY_FIXED)
+				{
+					flush_msg(std::cout,
+						M_ERROR,
+						M_PARSE,
+						M_CONF,
+						FIELD_CKRKEY,
+						_CKrkey);
+
+					return false;
+				}
+
+				// optional, ptables created
+				// natively unless "R"
+				_CKptable=_PT.get<std::string>(
+					FIELD_CKPTABLE, PTABLE_NATIVE);
+
+				if (_CKptable!=PTABLE_NATIVE && 
+					_CKptable!=PTABLE_R)
+				{
+					flush_msg(std::cout,
+						M_ERROR,
+						M_PARSE,
+						M_CONF,
+						FIELD_CKPTABLE,
+						_CKptable);
+
+					return false;
+				}
+
+				// optional, all of them
+				// unless listed
+				if (! parse_mechanisms())
+				{
+					return false;
+				}
+
+				if (is_compact() && 
+					! is_fixed_rkey())
+				{// 32 bits record keys
+					flush_msg(std::cout,
+						M_ERROR,
+						M_PARSE,
+						M_CONF,
+						FIELD_CELLS,
+						_Cells,
+						FIELD_CKRKEY,
+						_CKrkey);
+
+					return false;
+				}
+
 				if (! parse_exp())
 				{
 					return false;
 				}
 
+				if (! parse_marginals())
+				{
+					return false;
+				}
+
+				if (! parse_tables())
+				{
+					return false;
+				}
+
+				if (! parse_magnitude())
+				{
+					return false;
+				}
+
 				return true;
 			}
 
@@ -395,6 +636,15 @@ namespace confly
 				+_MID*_LocalCubes;
 		}
 
+		/// @brief get the ordinal of the
+		/// first of the commissioned 
+		/// hypercubes ("begin" field).
+		auto get_begin() const
+			->size_t
+		{
+			return _Begin;
+		}
+
 		/// @brief get the total number
 		/// of commissioned hypercubes.
 		auto get_size() const
@@ -403,6 +653,88 @@ namespace confly
 			return _Cubes;
 		}
 
+		/// @brief get the number of threads
+		/// aggregating each single hypercube
+		/// ("aggregation.threads" field).
+		/// @return const reference to unsigned
+		/// long, 0 meaning that the threads 
+		/// left idle by the cubes of the local
+		/// machine are split among them.
+		auto get_threads() const
+			->const size_t&
+		{// get threads per cube
+			return _Threads;
+		}
+
+		/// @brief test whether the hypercubes
+		/// are aggregated as flat arrays of
+		/// cells, radix-partitioned ("radix"
+		/// value of the "aggregation.mode"
+		/// field), rather than nested maps 
+		/// ("map", default).
+		auto is_radix() const
+			->bool
+		{// get aggregation mode
+			return _Mode==MODE_RADIX;
+		}
+
+		/// @brief test whether the plugin
+		/// must be specialized on the shape
+		/// of the flat hypercubes observed 
+		/// in the data ("aggregation.
+		/// specialize" field, radix mode 
+		/// only).
+		auto is_specialized() const
+			->const bool&
+		{// get specialize flag
+			return _BSpecialize;
+		}
+
+		/// @brief test whether the state
+		/// of the hypercubes is saved for
+		/// delta runs ("aggregation.state"
+		/// field, map mode only), with the
+		/// records keyed by their ordinal.
+		auto is_stateful() const
+			->const bool&
+		{// get state flag
+			return _BState;
+		}
+
+		/// @brief test whether only the
+		/// cells with support in the 
+		/// microdata are written, the
+		/// others being structural zeros
+		/// ("aggregation.sparse" field,
+		/// map mode only).
+		auto is_sparse() const
+			->const bool&
+		{// get sparse flag
+			return _BSparse;
+		}
+
+		/// @brief test whether the records
+		/// are sorted by their cells once
+		/// read ("aggregation.sort" field).
+		auto is_sorted() const
+			->const bool&
+		{// get sort flag
+			return _BSort;
+		}
+
+		/// @brief test whether the values
+		/// of the cells are stored in narrow
+		/// types ("compact" value of the
+		/// "aggregation.cells" field), rather
+		/// than in wide ones ("wide", default).
+		/// @note compact cells need the fixed
+		/// record keys (see is_fixed_rkey()).
+		auto is_compact() const
+			->bool
+		{// get cell layout
+			return _Cells==CELLS_COMPACT;
+		}
+
 		/// @brief get the sampling rate
 		/// of the microdata set ("rate"
 		/// field of the configuration).
@@ -418,19 +750,30 @@ namespace confly
 		/// field of the config. 
 		/// @return const reference to
 		/// unsigned long
-		/// @note this is not the seed
-		/// used to seed the pseudo random
-		/// generator, rather a hint. The
-		/// actual seed will take the machine
-		/// ID into account, in order to
-		/// avoid trivial seed collisions
-		/// among different machines.
+		/// @note the streams of each cube
+		/// are keyed by this seed and the
+		/// ordinal of the cube among all
+		/// the cubes, whatever the machine
+		/// generating it (no collisions 
+		/// among different machines).
 		auto get_seed() const 
 			->const size_t&
 		{// get prng seed
 			return _PrngSeed;
 		}
 
+		/// @brief test whether the streams
+		/// of the cubes are drawn by 
+		/// xoshiro256** ("xoshiro256" value
+		/// of the "prng.engine" field), 
+		/// rather than by Philox4x32-10
+		/// ("philox", or "mersennetwister").
+		auto is_xoshiro() const
+			->bool
+		{// get streams engine
+			return _PrngEng==ENGINE_XOSHIRO;
+		}
+
 		/// @brief get the size of the
 		/// test for differential privacy
 		/// distributions, as provided 
@@ -499,6 +842,43 @@ namespace confly
 			return _CKjs;
 		}
 
+		/// @brief test whether the record
+		/// keys are 32 bits fixed-point
+		/// numbers, summed modulo 2^32 
+		/// ("fixed" value of the "noise.
+		/// CK_rkey" field), rather than 
+		/// integers in the range of the
+		/// random engine ("engine", default).
+		auto is_fixed_rkey() const
+			->bool
+		{// get record keys mode
+			return _CKrkey==RKEY_FIXED;
+		}
+
+		/// @brief test whether '--ptable'
+		/// creates the ptable natively
+		/// ("native" value of the "noise.
+		/// CK_ptable" field, default) 
+		/// rather than by the "ptable" R
+		/// package ("R").
+		auto is_native_ptable() const
+			->bool
+		{// get ptable generator
+			return _CKptable==PTABLE_NATIVE;
+		}
+
+		/// @brief get the noise mechanisms
+		/// whose noise is drawn and written
+		/// (ref. "noise.mechanisms" field).
+		/// @return bit mask of MECH_CK,
+		/// MECH_DPF and MECH_DPG, MECH_ALL
+		/// if the field is missing.
+		auto get_mechanisms() const
+			->const size_t&
+		{// get mechanisms
+			return _Mechanisms;
+		}
+
 		/// @brief get a train of comma separated
 		/// types needed in order to generate
 		/// software plugins
@@ -532,6 +912,66 @@ namespace confly
 			return _Mask;
 		}
 
+		/// @brief get the marginal tables
+		/// to materialize in the hypercubes
+		/// (ref. "marginals" group).
+		/// @return cref to the vector of 
+		/// cases (see struct lattice), all
+		/// the cases compatible with the mask
+		/// if the group is missing.
+		auto get_lattice() const
+			->const lattice::container&
+		{// get marginals
+			return _Lattice;
+		}
+
+		/// @brief get the tables to write
+		/// (ref. "tables" group).
+		/// @return cref to the vector of 
+		/// tables, a single unnamed table 
+		/// with all the marginals if the 
+		/// group is missing.
+		auto get_tables() const
+			->const table_list&
+		{// get tables
+			return _Tables;
+		}
+
+		/// @brief get the position of the
+		/// field summed up in the magnitude
+		/// tables (ref. "magnitude" group).
+		/// @return the position in the 
+		/// microdata record, 0 (the record
+		/// ID) for counts only.
+		auto get_magnitude() const
+			->const size_t&
+		{// get magnitude field
+			return _Magnitude;
+		}
+
+		/// @brief get the recodes of the
+		/// fields applied when reading the
+		/// microdata (ref. "micro" "recode").
+		/// @return cref to the vector of
+		/// recodes, empty if none.
+		auto get_recodes() const
+			->const recode_list&
+		{// get recodes
+			return _Recodes;
+		}
+
+		/// @brief get the hierarchies of
+		/// the fields, whose ancestors are
+		/// rolled up from the leaves (ref.
+		/// "micro" "hierarchy").
+		/// @return cref to the vector of
+		/// hierarchies, empty if none.
+		auto get_hierarchies() const
+			->const hierarchy_list&
+		{// get hierarchies
+			return _Hierarchies;
+		}
+
 	private:
 
 		bool parse_machines()
@@ -595,11 +1035,52 @@ namespace confly
 				const tree_type& _Elem(
 					I->second);
 
+				// read "name", optional
+				_Names.push_back(
+					_Elem.get<std::string>(
+						ELEM_NAME, ""));
+
 				// read "type"
-				const std::string& _Ty( 
+				std::string _Ty( 
 					_Elem.get<std::string>(
 						ELEM_TYPE));
 
+				// read "recode", optional
+				auto _Rec(_Elem.get_child_optional(
+					ELEM_RECODE));
+
+				if (_Rec && ! parse_recode(
+					*_Rec, _Names.size()-1, _Ty))
+				{
+					flush_msg(std::cout,
+						M_ERROR, 
+						M_PARSE, 
+						M_CONF,
+						FIELD_EXP,
+						_Names.back(),
+						ELEM_RECODE);
+
+					return false;
+				}
+
+				// read "hierarchy", optional
+				auto _Hier(_Elem.get_child_optional(
+					ELEM_HIERARCHY));
+
+				if (_Hier && ! parse_hierarchy(
+					*_Hier, _Names.size()-1))
+				{
+					flush_msg(std::cout,
+						M_ERROR, 
+						M_PARSE, 
+						M_CONF,
+						FIELD_EXP,
+						_Names.back(),
+						ELEM_HIERARCHY);
+
+					return false;
+				}
+
 				auto T(I); ++T;
 				if (! append_type(
 					_Ty, T!=E))
@@ -637,6 +1118,511 @@ namespace confly
 			return true;
 		}
 
+		bool parse_marginals()
+		{// compute the cases of the
+			// lattice of marginals
+			const size_t _Width(_Size-1);
+
+			lattice::container _Full;
+
+			lattice::full(_Width, 
+				_Mask, _Full);
+
+			auto _Grp(_PT.get_child_optional(
+				FIELD_MARGINALS));
+
+			if (! _Grp)
+			{// all the marginals
+				_Lattice=_Full;
+
+				return true;
+			}
+
+			auto _Order(_Grp->get_optional<
+				size_t>(ELEM_MAXORDER));
+
+			auto _List(_Grp->get_child_optional(
+				ELEM_LIST));
+
+			// listed cases
+			std::set<lattice::case_type> 
+				_Listed;
+
+			if (_List)
+			for (auto I=_List->begin(),
+				E=_List->end(); I!=E;
+					++I)
+			{// each marginal is an array
+				// of field names; start 
+				// from the grand total
+				lattice::case_type _Case(
+					((lattice::case_type)1
+						<<_Width)-1);
+
+				for (auto J=I->second.begin(),
+					F=I->second.end(); J!=F;
+						++J)
+				{
+					const std::string _Name(
+						J->second.get_value<
+							std::string>());
+
+					lattice::case_type _Bit(0);
+
+					if (! field_bit(_Name, _Bit))
+					{// unknown or "cube=false"
+						flush_msg(std::cout,
+							M_ERROR, 
+							M_PARSE, 
+							M_CONF,
+							FIELD_MARGINALS,
+							_Name);
+
+						return false;
+					}
+
+					_Case&=~_Bit;
+				}
+
+				_Listed.insert(_Case);
+			}
+
+			_Lattice.clear();
+
+			for (size_t i=0; i<_Full.size();
+				++i)
+			{
+				const bool _BListed(
+					_Listed.count(_Full[i])>0);
+
+				const bool _BOrder(_Order &&
+					lattice::order(_Full[i], 
+						_Width)<=*_Order);
+
+				if (_BListed || _BOrder || 
+					(! _Order && ! _List))
+					_Lattice.push_back(
+						_Full[i]);
+			}
+
+			if (_Lattice.empty())
+			{
+				flush_msg(std::cout,
+					M_ERROR, 
+					M_PARSE, 
+					M_CONF,
+					FIELD_MARGINALS);
+
+				return false;
+			}
+
+			return true;
+		}
+
+		bool parse_tables()
+		{// split the lattice of marginals
+			// into the tables to write
+			const size_t _Width(_Size-1);
+
+			auto _Grp(_PT.get_child_optional(
+				FIELD_TABLES));
+
+			_Tables.clear();
+
+			if (! _Grp)
+			{// a single unnamed table
+				table_def _Def;
+				_Def._Cases=_Lattice;
+				_Tables.push_back(_Def);
+
+				return true;
+			}
+
+			const lattice::case_type _All(
+				((lattice::case_type)1
+					<<_Width)-1);
+
+			// marginals of any table
+			std::set<lattice::case_type>
+				_Union;
+
+			// fields of no table
+			lattice::case_type _Unused(
+				_All);
+
+			for (auto I=_Grp->begin(),
+				E=_Grp->end(); I!=E;
+					++I)
+			{
+				const tree_type& _Elem(
+					I->second);
+
+				table_def _Def;
+
+				_Def._Name=_Elem.get<
+					std::string>(ELEM_NAME, "");
+
+				bool _BDup(false);
+				for (size_t t=0; t<_Tables.size();
+					++t)
+				{
+					if (_Tables[t]._Name==
+						_Def._Name)
+						_BDup=true;
+				}
+
+				if (_Def._Name.empty() || _BDup)
+				{
+					flush_msg(std::cout,
+						M_ERROR, 
+						M_PARSE, 
+						M_CONF,
+						FIELD_TABLES,
+						_Def._Name);
+
+					return false;
+				}
+
+				// fields replaced by totals
+				lattice::case_type _TMask(
+					_All);
+
+				for (auto J=_Elem.get_child(
+					ELEM_FIELDS).begin(),
+					F=_Elem.get_child(
+					ELEM_FIELDS).end(); J!=F;
+						++J)
+				{
+					const std::string _Name(
+						J->second.get_value<
+							std::string>());
+
+					lattice::case_type _Bit(0);
+
+					if (! field_bit(_Name, _Bit))
+					{// unknown or "cube=false"
+						flush_msg(std::cout,
+							M_ERROR, 
+							M_PARSE, 
+							M_CONF,
+							FIELD_TABLES,
+							_Def._Name,
+							_Name);
+
+						return false;
+					}
+
+					_TMask&=~_Bit;
+				}
+
+				auto _Order(_Elem.get_optional<
+					size_t>(ELEM_MAXORDER));
+
+				for (size_t i=0; i<_Lattice.size();
+					++i)
+				{// the marginals of the table
+					// among the configured ones
+					const lattice::case_type& 
+						_Case(_Lattice[i]);
+
+					if (_Case != (_Case|_TMask))
+						continue;
+
+					if (_Order && lattice::order(
+						_Case, _Width)>*_Order)
+						continue;
+
+					_Def._Cases.push_back(_Case);
+					_Union.insert(_Case);
+				}
+
+				if (_Def._Cases.empty())
+				{
+					flush_msg(std::cout,
+						M_ERROR, 
+						M_PARSE, 
+						M_CONF,
+						FIELD_TABLES,
+						_Def._Name);
+
+					return false;
+				}
+
+				_Unused&=_TMask;
+
+				_Tables.push_back(_Def);
+			}
+
+			// aggregate only the fields
+			// of no table, and materialize
+			// only the marginals of some
+			// table
+			_Mask|=_Unused;
+
+			_Lattice.assign(_Union.begin(),
+				_Union.end());
+
+			return true;
+		}
+
+		bool parse_mechanisms()
+		{// subset of "CK", "DPF", "DPG"
+			auto _List(_PT.get_child_optional(
+				FIELD_MECHANISMS));
+
+			_Mechanisms=MECH_ALL;
+
+			if (! _List)
+				return true;
+
+			_Mechanisms=0;
+
+			for (auto I=_List->begin(),
+				E=_List->end(); I!=E;
+					++I)
+			{
+				const std::string _Name(I->second
+					.get_value<std::string>());
+
+				if (_Name==S_MECH_CK)
+					_Mechanisms|=MECH_CK;
+
+				else if (_Name==S_MECH_DPF)
+					_Mechanisms|=MECH_DPF;
+
+				else if (_Name==S_MECH_DPG)
+					_Mechanisms|=MECH_DPG;
+
+				else
+				{
+					flush_msg(std::cout,
+						M_ERROR, 
+						M_PARSE, 
+						M_CONF,
+						FIELD_MECHANISMS,
+						_Name);
+
+					return false;
+				}
+			}
+
+			if (0==_Mechanisms)
+			{
+				flush_msg(std::cout,
+					M_ERROR, 
+					M_PARSE, 
+					M_CONF,
+					FIELD_MECHANISMS);
+
+				return false;
+			}
+
+			return true;
+		}
+
+		bool parse_magnitude()
+		{// field to sum up, if any
+			auto _Name(_PT.get_optional<
+				std::string>(FIELD_MAGNITUDE));
+
+			_Magnitude=0;
+
+			if (! _Name)
+				return true;
+
+			// skip the id
+			size_t k=1;
+			for (; k<_Names.size() &&
+				_Names[k]!=*_Name; ++k);
+
+			if (k==_Names.size())
+			{
+				flush_msg(std::cout,
+					M_ERROR, 
+					M_PARSE, 
+					M_CONF,
+					FIELD_MAGNITUDE,
+					*_Name);
+
+				return false;
+			}
+
+			_Magnitude=k;
+
+			return true;
+		}
+
+		bool parse_recode(
+			const tree_type& _Grp,
+			const size_t& _Field,
+			std::string& _Ty)
+		{// one of "bins", "map" or
+			// "truncate"; bins are
+			// integer codes
+			auto _Bins(_Grp.get_child_optional(
+				ELEM_BINS));
+			auto _Map(_Grp.get_child_optional(
+				ELEM_MAP));
+			auto _Len(_Grp.get_optional<
+				size_t>(ELEM_TRUNCATE));
+
+			if (1!=(_Bins ? 1 : 0)+
+				(_Map ? 1 : 0)+(_Len ? 1 : 0))
+				return false;
+
+			recode _R;
+
+			_R._Field=_Field;
+
+			if (_Bins)
+			{
+				_R._Kind=recode::BINS;
+
+				for (auto I=_Bins->begin(),
+					E=_Bins->end(); I!=E; 
+						++I)
+				{
+					const double _Cut(I->second
+						.get_value<double>());
+
+					if (! _R._Cuts.empty() &&
+						_Cut<=_R._Cuts.back())
+						return false;
+
+					_R._Cuts.push_back(_Cut);
+				}
+
+				if (_R._Cuts.empty())
+					return false;
+
+				_Ty="int";
+			}
+
+			else if (_Map)
+			{
+				_R._Kind=recode::MAP;
+
+				for (auto I=_Map->begin(),
+					E=_Map->end(); I!=E; 
+						++I)
+				{
+					_R._Map[I->first]=I->second
+						.get_value<std::string>();
+				}
+
+				_R._Other=_Grp.get<std::string>(
+					ELEM_OTHER, "");
+
+				if (_R._Map.empty())
+					return false;
+			}
+
+			else
+			{
+				_R._Kind=recode::TRUNCATE;
+				_R._Len=*_Len;
+
+				if (0==_R._Len)
+					return false;
+			}
+
+			_Recodes.push_back(_R);
+
+			return true;
+		}
+
+		bool parse_hierarchy(
+			const tree_type& _Grp,
+			const size_t& _Field)
+		{// either "levels" (lengths of
+			// the prefixes) or "file" 
+			// (child;parent lines); map
+			// mode only, without state
+			auto _Levels(_Grp.get_child_optional(
+				ELEM_LEVELS));
+			auto _File(_Grp.get_optional<
+				std::string>(ELEM_FILE));
+
+			if (0==_Field || is_radix() ||
+				is_stateful() ||
+				(_Levels ? 1 : 0)+
+				(_File ? 1 : 0)!=1)
+				return false;
+
+			hierarchy_def _H;
+
+			_H._Field=_Field;
+
+			if (_Levels)
+			for (auto I=_Levels->begin(),
+				E=_Levels->end(); I!=E; 
+					++I)
+			{
+				const size_t _Len(I->second
+					.get_value<size_t>());
+
+				if (0==_Len || (! _H._Levels
+					.empty() &&
+					_Len<=_H._Levels.back()))
+					return false;
+
+				_H._Levels.push_back(_Len);
+			}
+
+			if (_File)
+			{
+				std::ifstream _Fin(*_File);
+
+				if (! _Fin.good())
+					return false;
+
+				std::string _Ln;
+
+				while (std::getline(_Fin, _Ln))
+				{
+					if (! _Ln.empty() && '\r'==
+						_Ln[_Ln.size()-1])
+						_Ln.resize(_Ln.size()-1);
+
+					const size_t _Sep(
+						_Ln.find(CHARSC));
+
+					if (_Sep==std::string::npos)
+						continue;
+
+					_H._Parents[_Ln.substr(0,
+						_Sep)]=_Ln.substr(_Sep+1);
+				}
+			}
+
+			if (_H._Levels.empty() &&
+				_H._Parents.empty())
+				return false;
+
+			_Hierarchies.push_back(_H);
+
+			return true;
+		}
+
+		bool field_bit(
+			const std::string& _Name,
+			lattice::case_type& _Bit) const
+		{// bit of a field in the cases,
+			// false if unknown or masked
+
+			// skip the id
+			size_t k=1;
+			for (; k<_Names.size() &&
+				_Names[k]!=_Name; ++k);
+
+			if (k==_Names.size())
+				return false;
+
+			_Bit=(lattice::case_type)1<<(k-1);
+
+			return 0==(_Mask & _Bit);
+		}
+
 		bool append_type(
 			const std::string& _Ty,
 			bool _BSep)
@@ -693,6 +1679,20 @@ namespace confly
 			_Cubes;
 		int
 			_Begin;
+		size_t
+			_Threads;
+		std::string
+			_Mode;
+		bool
+			_BSpecialize;
+		bool
+			_BState;
+		bool
+			_BSparse;
+		bool
+			_BSort;
+		std::string
+			_Cells;
 		std::string 
 			_PrngEng;
 		size_t 
@@ -711,6 +1711,12 @@ namespace confly
 			_CKvar;
 		double
 			_CKjs;
+		std::string
+			_CKrkey;
+		std::string
+			_CKptable;
+		size_t
+			_Mechanisms;
 		size_t 
 			_Size;
 		std::string
@@ -719,5 +1725,17 @@ namespace confly
 			_TypeCode;
 		size_t
 			_Mask;
+		std::vector<std::string>
+			_Names;
+		lattice::container
+			_Lattice;
+		table_list
+			_Tables;
+		size_t
+			_Magnitude;
+		recode_list
+			_Recodes;
+		hierarchy_list
+			_Hierarchies;
 	};
 }
\ No newline at end of file
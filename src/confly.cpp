@@ -1,3 +1,5 @@
+#include <omp.h>
+
 #include "confly.hpp"
 #include "cluster.hpp"
 
@@ -42,6 +44,18 @@ namespace confly
 			_BNoTraverse(
 				false);
 
+		// if set, appended microdata
+		// aggregated into the state
+		// of the previous run
+		std::string
+			_DeltaFname;
+
+		// if not negative, the global
+		// ordinal of the only cube
+		// regenerated by --aggregate
+		long
+			_ReplayCube(-1);
+
 		size_t
 			_RandomTestDraws(1000);
 	}
@@ -74,16 +88,21 @@ service_api service(
 	const std::string& _cPathOutput,
 	const std::string& _cTypes,
 	const std::string& _cTypeCode,
-	const size_t& _cMask)
+	const size_t& _cMask,
+	const table_list& _cTables,
+	const plugin_defines& _cDefines)
 	: _PathProject(_cPathProject)
 	, _PathOutput(_cPathOutput)
 	, _Types(_cTypes)
 	, _TypeCode(_cTypeCode)
 	, _Mask(_cMask)
+	, _Defines(_cDefines)
 	, _Plugin(
 		_cPathProject,
 		_cTypeCode,
-		_cMask)
+		_cMask,
+		_cTables,
+		_cDefines)
 {
 	init();
 }
@@ -113,7 +132,8 @@ void service_api init()
 		if (! plugin::create(
 			_PathProject,
 			_Types,
-			_TypeCode))
+			_TypeCode,
+			_Defines))
 		{
 			fail(M_PLUGIN);
 
@@ -195,7 +215,8 @@ bool confly_api load_config(
 
 bool confly_api read_micro(
 	micro_base_ptr _Micro, 
-	const std::string& _Fname)
+	const std::string& _Fname,
+	const recode_list& _Recodes)
 {
 	// protect against null ptr
 	if (! _Micro)
@@ -215,8 +236,40 @@ bool confly_api read_micro(
 		return false;
 	}
 
-	if (! _Micro->read(_Fin, 
-		CHARSC))
+	bool _BRead(true);
+
+	if (_Recodes.empty())
+		_BRead=_Micro->read(_Fin, 
+			CHARSC);
+
+	else while (_BRead && _Fin.good())
+	{// recode a batch of lines at a 
+		// time, then read it
+		std::vector<std::string> _Lines;
+
+		std::string _Ln;
+
+		while (_Lines.size()<_RecodeBatch &&
+			std::getline(_Fin, _Ln))
+			_Lines.push_back(_Ln);
+
+		recode_lines(_Recodes, CHARSC, 
+			_Lines);
+
+		std::ostringstream _OSS;
+
+		for (size_t i=0; i<_Lines.size();
+			++i)
+			_OSS << _Lines[i] << '\n';
+
+		std::istringstream _ISS(
+			_OSS.str());
+
+		_BRead=_Micro->read(_ISS, 
+			CHARSC);
+	}
+
+	if (! _BRead)
 	{// error read operation
 		flush_msg(std::cout,
 			M_ERROR,
@@ -230,6 +283,90 @@ bool confly_api read_micro(
 	return true;
 }
 
+// -----------------------------------------
+// plugin defines set by the configuration
+
+auto confly_api config_defines(
+	const config& _Config)
+	->plugin_defines
+{
+	plugin_defines _Defines;
+
+	if (_Config.get_magnitude()>0)
+	{// sum up the magnitude field
+		std::ostringstream _OSS;
+		_OSS << _Config.get_magnitude();
+
+		_Defines[DEF_MAGNITUDE]=
+			_OSS.str();
+	}
+
+	if (_Config.is_fixed_rkey())
+	{// 32 bits record keys
+		_Defines[DEF_FIXED_RKEY]="1";
+	}
+
+	if (_Config.is_compact())
+	{// narrow cell values
+		_Defines[DEF_COMPACT_CELLS]="1";
+	}
+
+	if (_Config.is_xoshiro())
+	{// streams of the cubes
+		_Defines[DEF_XOSHIRO]="1";
+	}
+
+	if (_Config.get_mechanisms()!=MECH_ALL)
+	{// only the listed mechanisms
+		// in the cells and the output
+		std::ostringstream _OSS;
+		_OSS << _Config.get_mechanisms();
+
+		_Defines[DEF_MECHANISMS]=
+			_OSS.str();
+	}
+
+	return _Defines;
+}
+
+// -----------------------------------------
+// probe the shape of the cubes
+
+bool confly_api probe_shape(
+	const config& _Config,
+	plugin_defines& _Defines)
+{
+	// read and encode the microdata
+	// with the plugin not yet shape
+	// specialized, in order to get
+	// the cardinalities of the fields.
+	service _Srv(
+		_Config.get_path(),
+		_Config.get_output_path(),
+		_Config.get_type(),
+		_Config.get_typecode(),
+		_Config.get_mask(),
+		_Config.get_tables(),
+		_Defines);
+
+	if (! _Srv.good())
+		return false;
+
+	micro_base_ptr _DB(
+		_Srv->make_micro());
+
+	if (! read_micro(_DB, 
+		_Config.get_input(),
+		_Config.get_recodes()) ||
+		! _DB->encode())
+		return false;
+
+	_Defines[DEF_SHAPE]=
+		_DB->shape();
+
+	return true;
+}
+
 // -----------------------------------------
 // create cube filename
 
@@ -247,6 +384,38 @@ auto confly_api cube_fname(
 	return _OSS.str();
 }
 
+// -----------------------------------------
+// create state filename
+
+auto confly_api state_fname(
+	const std::string& _Path,
+	const size_t _Idx)
+	->std::string
+{// e.g. path/to/state_0.csv
+	std::ostringstream 
+		_OSS; _OSS 
+		<< _Path << CHARSL
+		<< OF_STATE << CHARUS 
+		<< _Idx << DOT_CSV;
+
+	return _OSS.str();
+}
+
+// -----------------------------------------
+// read the header of a state file
+
+bool confly_api read_state_base(
+	const std::string& _Fname,
+	size_t& _Base)
+{// 1st line: number of records
+	// aggregated so far
+	std::ifstream _Fin(_Fname);
+
+	_Fin >> _Base;
+
+	return ! _Fin.fail();
+}
+
 // -----------------------------------------
 // show version
 
@@ -289,6 +458,17 @@ auto confly_api usage()
 	::puts("                         creates the traversing files;");
 	::puts("                         use '--no-traverse' option to");
 	::puts("                         create the hypercubes only.");
+	::puts("         --delta <file>  with '--aggregate', add the");
+	::puts("                         appended microdata in <file>");
+	::puts("                         to the state saved by the");
+	::puts("                         previous run (see config");
+	::puts("                         'aggregation.state').");
+	::puts("         --replay-cube <n>");
+	::puts("                         regenerate the hypercube of");
+	::puts("                         global ordinal <n> alone,");
+	::puts("                         as created by '--aggregate'.");
+	::puts("                         Its traversing and state");
+	::puts("                         files are not written.");
 	::puts("         --distribute    distribute the aggregation to");
 	::puts("                         multiple machines. On each");
 	::puts("                         machine 'exppert --aggregate");
@@ -301,6 +481,8 @@ auto confly_api usage()
 	::puts("");
 	::puts("./exppert -c config.json --aggregate");
 	::puts("./exppert -c config.json --aggregate --no-traverse");
+	::puts("./exppert -c config.json --aggregate --delta new.csv");
+	::puts("./exppert -c config.json --replay-cube 17");
 	::puts("./exppert -c config.json --distribute");
 	::puts("./exppert -c config.json --traverse");
 	::puts("");
@@ -534,6 +716,52 @@ auto confly_api cmdline_opts(
 				true;
 		}
 
+		else if (! strcmp(
+			argv[i], O_DELTA))
+		{// --delta
+			++i; if (i==argc)
+			{
+				flush_msg(
+					std::cout,
+					O_DELTA,
+					M_MISSING,
+					M_MICRO,
+					M_FILENAME);
+				return C_HELP;
+			}
+
+			options
+			::_DeltaFname=
+				argv[i];
+		}
+
+		else if (! strcmp(
+			argv[i], O_REPLAY))
+		{// --replay-cube, implies
+			// --aggregate
+			++i; char* _End(0);
+
+			if (i<argc)
+				options
+				::_ReplayCube=
+					::strtol(argv[i], 
+						&_End, 10);
+
+			if (i==argc || *_End ||
+				options::_ReplayCube<0)
+			{
+				flush_msg(
+					std::cout,
+					O_REPLAY,
+					M_MISSING,
+					M_HYCUBE,
+					M_ORDINAL);
+				return C_HELP;
+			}
+
+			_Cmd=C_AGGREGATE;
+		}
+
 		else if (! strcmp(
 			argv[i], O_CODELIST))
 			// --code-list
@@ -599,6 +827,46 @@ auto confly_api crt_ptable()
 		return 0;
 	}
 
+	if (_Config.is_native_ptable())
+	{// no R: the same table as
+		// the "ptable" package
+		ptable _New; 
+
+		if (! generate_ptable(_New,
+			_Config.get_CKD(),
+			_Config.get_CKvar(),
+			_Config.get_CKjs()))
+		{// the existing file is kept
+			flush_msg(std::cout, 
+				M_ERROR, 
+				M_PTABLE,
+				M_CREATE);
+			return 0;
+		}
+
+		// opened (and truncated) only
+		// once the table is generated
+		std::ofstream _Fout(
+			_Config.get_ptable());
+
+		if (! _Fout.good())
+		{
+			flush_msg(std::cout, 
+				M_ERROR, 
+				M_OPEN,
+				M_PTABLE,
+				M_FILE);
+			return 0;
+		}
+
+		// as R writes the numbers
+		_Fout << std::setprecision(15);
+
+		_New.write(_Fout);
+
+		return 0;
+	}
+
 	std::ostringstream 
 		_OSS; _OSS 
 		<< _Config.get_path()
@@ -706,18 +974,51 @@ auto confly_api aggregate()
 			M_OF, _Machines, M_MACHINES);
 	}
 
+	// replay: the streams of a cube
+	// are keyed by the seed and its
+	// global ordinal only, so that
+	// any cube can be regenerated
+	// alone, on any machine
+	const bool _BReplay(
+		options::_ReplayCube>=0);
+
 	// number of cubes to be created
 	// by the local machine
-	const int _LocalCubes(
-		_Config.get_cubes_mid(
+	const int _LocalCubes(_BReplay ?
+		1 : _Config.get_cubes_mid(
 			_MID));
 
 	// prepare filename id
 	// for the 1st cube
-	size_t _CubesBeg(
+	size_t _CubesBeg(_BReplay ?
+		options::_ReplayCube :
 		_Config.get_cubes_begin(
 			_MID));
 
+	if (_BReplay && (_CubesBeg<
+		_Config.get_begin() ||
+		_CubesBeg>=_Config.get_begin()
+			+_CubeSz || ! options
+			::_DeltaFname.empty()))
+	{// out of range, or the state
+		// the cube was aggregated
+		// into is gone
+		flush_msg(std::cout,
+			M_ERROR,
+			O_REPLAY,
+			_CubesBeg, M_OF,
+			M_TOTAL, _CubeSz, 
+			M_HYCUBES);
+		return 0;
+	}
+
+	if (_BReplay)
+		// a single cube does not
+		// update the traversing 
+		// files of the others
+		options::_BNoTraverse=
+			true;
+
 	flush_msg(std::cout, 
 		_HName, M_IS,
 		M_TO, M_CREATE, 
@@ -725,12 +1026,35 @@ auto confly_api aggregate()
 		M_TOTAL, _CubeSz, M_HYCUBES, 
 		M_START, M_FROM, M_ORDINAL, _CubesBeg);
 
+	// with flat cubes, the plugin
+	// can be specialized on the
+	// shape of the cubes as found
+	// in the data (generated and
+	// compiled at the first run).
+	plugin_defines _Defines(
+		config_defines(_Config));
+
+	if (_Config.is_radix() &&
+		_Config.is_specialized() &&
+		! probe_shape(_Config, 
+			_Defines))
+	{
+		flush_msg(std::cout,
+			M_ERROR,
+			M_PLUGIN,
+			M_CELLS);
+
+		return 0;
+	}
+
 	service _Srv(
 		_Config.get_path(),
 		_Config.get_output_path(),
 		_Config.get_type(),
 		_Config.get_typecode(),
-		_Config.get_mask());
+		_Config.get_mask(),
+		_Config.get_tables(),
+		_Defines);
 	
 	if (! _Srv.good())
 	{// plugin creation failed
@@ -754,6 +1078,12 @@ auto confly_api aggregate()
 		_Config.get_DPFb(),
 		_Config.get_DPGeps());
 
+	// transfer the mechanisms
+	// whose noise is drawn and
+	// written
+	_Srv->import_mechanisms(
+		_Config.get_mechanisms());
+
 	// allocate traversing vectors
 	// only if traversing is requested.
 	// this causes the response
@@ -771,27 +1101,112 @@ auto confly_api aggregate()
 		// = yes traverse
 		_Srv->import_size(_CubeSz);
 
-	// seed prng summing the provided
-	// seed-value in the config file
-	// and '_CubesBeg' (i.e. the number 
-	// of the first cube worked out
-	// on this machine).
-	// if only the local machine is used,
-	// _CubesBeg=0 thus the PRNG is seeded
-	// with the value provided in the
-	// config.
+	// split the threads of this
+	// machine between the cubes
+	// and the records of each
+	// cube. Unless configured, the 
+	// threads left idle by the
+	// cubes aggregate the records
+	// of the cubes in parallel.
+	const size_t _MaxThreads(
+		omp_get_max_threads());
+
+	size_t _CubeThreads(
+		_Config.get_threads());
+
+	if (0==_CubeThreads)
+		_CubeThreads=std::max<size_t>(1,
+			_MaxThreads/std::max<size_t>(
+				1, _LocalCubes));
+
+	const size_t _OuterThreads(
+		std::max<size_t>(1, 
+			_MaxThreads/_CubeThreads));
+
+	if (_CubeThreads>1)
+		// allow nested parallel
+		// regions in the plugin
+		omp_set_max_active_levels(2);
+
+	_Srv->import_threads(
+		_CubeThreads);
+
+	// flat cubes, radix-partitioned
+	// aggregation
+	_Srv->import_radix(
+		_Config.is_radix());
+
+	// seed prng with the seed-value
+	// in the config file, the same on
+	// all the machines: the streams
+	// of each cube are keyed by the
+	// seed and its global ordinal 
+	// (i+_CubesBeg), not by the cubes
+	// assigned to this machine, so 
+	// that any split of the cubes 
+	// among the machines, or a rerun
+	// of a range, yields the same
+	// cubes. The record keys are the
+	// same on all the machines too.
 	_Srv->seed_prng(
-		_Config.get_seed()+
-		_CubesBeg);
+		_Config.get_seed());
+
+	// delta run: the appended
+	// records are aggregated into
+	// the state saved by the
+	// previous run
+	const bool _BDelta(! options
+		::_DeltaFname.empty());
+
+	if (_BDelta && ! _Config
+		.is_stateful())
+	{
+		flush_msg(std::cout,
+			M_ERROR,
+			O_DELTA,
+			M_MISSING,
+			M_CONF,
+			FIELD_STATE);
+		return 0;
+	}
+
+	// number of records aggregated
+	// by the previous runs, same in
+	// all the state files
+	size_t _Base(0);
+
+	if (_BDelta && ! read_state_base(
+		state_fname(_Config
+			.get_output_path(), 
+			_CubesBeg), _Base))
+	{
+		flush_msg(std::cout,
+			M_ERROR,
+			M_READ,
+			M_STATE,
+			_CubesBeg);
+		return 0;
+	}
 
 	// create microDB
 	micro_base_ptr _DB(
 		_Srv->make_micro());
 
+	// with saved state, record keys
+	// and samples are keyed by the
+	// ordinal of the records, so
+	// that delta runs reproduce them
+	if (_Config.is_stateful())
+		_DB->set_keyed(
+			_Config.get_seed(), 
+			_Base);
+
 	// read the microdata
 	// file, or fail and stop.
-	if (! read_micro(_DB, 
-		_Config.get_input()))
+	if (! read_micro(_DB, _BDelta ?
+		options::_DeltaFname :
+		_Config.get_input(),
+		_Config.get_recodes()))
 	{
 		flush_msg(std::cout,
 			M_ERROR,
@@ -801,6 +1216,59 @@ auto confly_api aggregate()
 		return 0;
 	}
 
+	// group the records by cell,
+	// once for all the cubes
+	if (_Config.is_sorted())
+		_DB->sort();
+
+	// the ancestors of the values
+	// of the hierarchies
+	if (! _Config.get_hierarchies()
+		.empty())
+		_DB->set_hierarchies(
+			_Config.get_hierarchies());
+
+	// the cells with support, read
+	// before the saved state's ones
+	if (_Config.is_sparse())
+		_DB->build_support();
+
+	if (_BDelta)
+	{// the values found in the 
+		// previous runs
+		std::ifstream _Fin(
+			state_fname(_Config
+				.get_output_path(), 
+				_CubesBeg));
+
+		std::string _Hdr; 
+		std::getline(_Fin, _Hdr);
+
+		if (! _DB->read_meta(
+			_Fin, CHARSC))
+		{
+			flush_msg(std::cout,
+				M_ERROR,
+				M_READ,
+				M_STATE,
+				_CubesBeg);
+			return 0;
+		}
+	}
+
+	// dictionary encode the
+	// microdata for flat cubes
+	if (_Config.is_radix() &&
+		! _DB->encode())
+	{
+		flush_msg(std::cout,
+			M_ERROR,
+			M_HYCUBE,
+			M_CELLS,
+			M_CUMBER);
+		return 0;
+	}
+
 	// start timing machine's
 	// total processing time.
 	stopwatch _SWTotal;
@@ -820,7 +1288,8 @@ auto confly_api aggregate()
 				_Srv->make_hypercube()));
 	}
 
-	#pragma omp parallel for
+	#pragma omp parallel for \
+		num_threads(_OuterThreads)
 	for (size_t i=0; i<_LocalCubes;
 		++i)
 	{// generate _CubeSz hypercubes
@@ -833,16 +1302,43 @@ auto confly_api aggregate()
 		// cube updates the vector
 		// of values of specific 
 		// coordinates at its ID 
-		// position.
-		// if not traversing, the
-		// cube id is not used.
+		// position, among the cubes
+		// of this machine; its
+		// ordinal among all the
+		// cubes keys its draws.
 		_Cube->set_id(i);
+		_Cube->set_ordinal(
+			i+_CubesBeg);
 
 		const std::string _Fname(
 			cube_fname(_Config
+				.get_output_path(), 
+				i+_CubesBeg)),
+			_SFname(state_fname(_Config
 				.get_output_path(), 
 				i+_CubesBeg));
 
+		if (_BDelta)
+		{// cells of the previous run,
+			// header skipped
+			std::ifstream _Fin(
+				_SFname);
+
+			std::string _Hdr; 
+			std::getline(_Fin, _Hdr);
+
+			if (! _Cube->read_state(
+				_Fin))
+			{
+				flush_msg(std::cout,
+					M_ERROR,
+					M_READ,
+					M_STATE,
+					i+_CubesBeg);
+				continue;
+			}
+		}
+
 		// service->plugin->sample_micro
 		if (! _Srv->sample_micro(
 			_DB.get(),
@@ -855,6 +1351,21 @@ auto confly_api aggregate()
 				M_ERROR);
 		}
 
+		if (_Config.is_stateful() &&
+			! _BReplay)
+		{// save for the next delta
+			// run: records aggregated
+			// so far, then the cells
+			std::ofstream _Fout(
+				_SFname);
+
+			_Fout << _Base+_DB->size()
+				<< CHARNL;
+
+			_Cube->write_state(
+				_Fout);
+		}
+
 		flush_msg(std::cout,
 			_HName, CHARCC, 
 			M_HYCUBE, i+_CubesBeg, 
@@ -915,7 +1426,9 @@ auto confly_api distribute()
 		_Config.get_output_path(),
 		_Config.get_type(),
 		_Config.get_typecode(),
-		_Config.get_mask());
+		_Config.get_mask(),
+		_Config.get_tables(),
+		config_defines(_Config));
 	
 	if (! _Srv.good())
 	{// plugin creation failed
@@ -1075,7 +1588,9 @@ auto confly_api traverse()
 		_Config.get_output_path(),
 		_Config.get_type(),
 		_Config.get_typecode(),
-		_Config.get_mask());
+		_Config.get_mask(),
+		_Config.get_tables(),
+		config_defines(_Config));
 	
 	if (! _Srv.good())
 	{// plugin creation failed
@@ -1094,6 +1609,11 @@ auto confly_api traverse()
 
     _Srv->import_size(_CubeSz);
 
+	// tables to traverse
+	const table_list& 
+		_Tables(_Config
+			.get_tables());
+
 	// preallocate cubes
 	std::vector<hypercube_base_ptr>
 		_Cubes; for (size_t i=0; 
@@ -1127,27 +1647,41 @@ auto confly_api traverse()
 				.get_output_path(), 
 				i));
 
-        std::ifstream _Fin(
-            _Fname); if(_Fin
-                .good())
-        {
-            if (! _Cube
-                ->read(_Fin))
-            {// read error, stop
-                flush_msg(std::cout,
-                    M_ERROR, 
-                    M_READ, 
-                    M_HYCUBE,
-                    i, 
-                    M_ABORTING);
-
-                return 0;
-            }
-        }
+		for (size_t t=0; t<_Tables.size();
+			++t)
+		{// read the file of each table,
+			// the shared cells are read
+			// more than once
+			std::ifstream _Fin(
+				table_fname(_Fname, 
+					_Tables[t]._Name)); 
+			if(_Fin.good())
+			{
+				if (! _Cube
+					->read(_Fin))
+				{// read error, stop
+					flush_msg(std::cout,
+						M_ERROR, 
+						M_READ, 
+						M_HYCUBE,
+						i, 
+						M_ABORTING);
+
+					return 0;
+				}
+			}
+		}
 	}
 
-    _Cubes[0]->write_traversing(
-        _Config.get_output_path());
+	for (size_t t=0; t<_Tables.size();
+		++t)
+	{// one set of traversing files
+		// per table
+		_Cubes[0]->write_traversing(
+			_Config.get_output_path(),
+			_Tables[t]._Name,
+			_Tables[t]._Cases);
+	}
 
     flush_msg(std::cout,
         M_TRAVERSED, _CubeSz, 
@@ -1345,9 +1879,23 @@ auto confly_api random_draws()
         std::ofstream _Fout(
             _OSS.str());
 
+        // the engine configured
+        // for the cubes' streams
+        xoshiro256 _XO; _XO.seed(
+            _Config.get_seed(), 0,
+                STREAM_DPF);
+
         for (size_t i=0; 
             i<_RSz; ++i)
         {
+            if (_Config.is_xoshiro())
+            _Fout 
+            << _Laplace(_XO) 
+            << CHARSC 
+            << _Geometric(_XO) 
+            << CHARNL;
+
+            else
             _Fout 
             << _Laplace(_MT) 
             << CHARSC 
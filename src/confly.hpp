@@ -26,6 +26,12 @@ namespace confly
 
         extern bool 
             _BNoTraverse;
+
+        extern std::string 
+            _DeltaFname;
+
+        extern long
+            _ReplayCube;
     }
 
     /// @brief utility class to hold
@@ -45,7 +51,10 @@ namespace confly
 			const std::string& _cPathOutput,
 			const std::string& _cTypes,
 			const std::string& _cTypeCode,
-            const size_t& _cMask);
+            const size_t& _cMask,
+            const table_list& _cTables,
+            const plugin_defines& _cDefines=
+                plugin_defines());
 
         /// @brief Deinit and destroy.
 		~ service();
@@ -81,6 +90,8 @@ namespace confly
 			_TypeCode;
         size_t
             _Mask;
+        plugin_defines
+            _Defines;
 		plugin
 			_Plugin;
 	};
@@ -104,13 +115,31 @@ namespace confly
 
     bool read_micro(
         micro_base_ptr _Micro, 
-        const std::string& _Fname);
+        const std::string& _Fname,
+        const recode_list& _Recodes);
+
+    auto config_defines(
+        const config& _Config)
+        ->plugin_defines;
+
+    bool probe_shape(
+        const config& _Config,
+        plugin_defines& _Defines);
 
     auto cube_fname(
         const std::string& _Path,
         const size_t _Idx)
         ->std::string;
 
+    auto state_fname(
+        const std::string& _Path,
+        const size_t _Idx)
+        ->std::string;
+
+    bool read_state_base(
+        const std::string& _Fname,
+        size_t& _Base);
+
     // parse cmd line arguments
     auto cmdline_opts(
         int argc, 
@@ -11,6 +11,9 @@
 #include <map>
 #include <vector>
 
+// ISO algorithms
+#include <algorithm>
+
 // ISO maths
 #include <cmath>
 #include <random>
@@ -100,6 +103,7 @@
 // output filename prefixes
 #define OF_CUBE                "cube"
 #define OF_TRAV                "trv"
+#define OF_STATE               "state"
 #define OF_ECDF                "ecdf"
 #define OF_RAND                "rand"
 
@@ -146,6 +150,8 @@
 #define M_TYPES                "types"
 #define M_RECORD               "record"
 #define M_RECORDS              "records"
+#define M_CELLS                "cells"
+#define M_STATE                "state"
 #define M_TREE                 "tree"
 #define M_CELLKEY              "cellkey"
 #define M_HYCUBE               "hypercube"
@@ -161,6 +167,7 @@
 #define M_RATE                 "rate"
 #define M_CONNECTOR            "connector"
 #define M_SUPPORT              "support"
+#define M_VARIANCE             "variance"
 #define M_PASSWORD             "password"
 #define M_BYTES                "bytes"
 #define M_SSH                  "ssh"
@@ -240,6 +247,24 @@
 #define M_PLUGIN               "plugin"
 #define M_RTTG_TYPES           "rttg_types"
 
+// plugin defines
+#define DEF_SHAPE              "SHAPE"
+#define DEF_MAGNITUDE          "MAGNITUDE"
+#define DEF_FIXED_RKEY         "FIXED_RKEY"
+#define DEF_COMPACT_CELLS      "COMPACT_CELLS"
+#define DEF_MECHANISMS         "MECHANISMS"
+#define DEF_XOSHIRO            "XOSHIRO"
+
+// noise mechanisms, bits of the
+// mask of the mechanisms requested
+#define MECH_CK                1
+#define MECH_DPF               2
+#define MECH_DPG               4
+#define MECH_ALL               7
+#define S_MECH_CK              "CK"
+#define S_MECH_DPF             "DPF"
+#define S_MECH_DPG             "DPG"
+
 // misc
 #define M_ELLIP                "..."
 #define M_THE                  "the"
@@ -266,6 +291,8 @@
 #define O_PTABLE               "--ptable"
 #define O_AGGR                 "--aggregate"
 #define O_NOTRAVERSE           "--no-traverse"
+#define O_DELTA                "--delta"
+#define O_REPLAY               "--replay-cube"
 #define O_DIST                 "--distribute"
 #define O_TRAV                 "--traverse"
 #define O_PLOT                 "--plot"
@@ -0,0 +1,125 @@
+#pragma once
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace confly
+{
+    /// @brief the hierarchy of a field of
+    /// the microdata, whose values are the
+    /// leaves (see config "micro"
+    /// "hierarchy").
+    /// @note the ancestors of each leaf
+    /// are given either by the prefixes of
+    /// the code (e.g. NUTS, NACE) or by a
+    /// mapping of the codes to their
+    /// parents. The cells of the ancestors
+    /// are summed up from the leaf cells
+    /// once the cubes are aggregated (see
+    /// hypercube::roll_up()).
+    struct hierarchy_def
+    {
+        /// @brief construct empty.
+        hierarchy_def()
+            : _Field(0)
+            , _Levels()
+            , _Parents()
+        {
+        }
+
+        /// @brief get the ancestors of a
+        /// leaf, from the closest.
+        /// @param _Leaf the code of the leaf.
+        /// @param _Out destination vector.
+        void ancestors(
+            const std::string& _Leaf,
+            std::vector<std::string>& _Out)
+            const
+        {
+            _Out.clear();
+
+            for (size_t l=_Levels.size();
+                l>0; --l)
+            {// prefixes, longest first
+                if (_Levels[l-1]<_Leaf.size())
+                    _Out.push_back(_Leaf
+                        .substr(0, _Levels[l-1]));
+            }
+
+            std::string _Code(_Leaf);
+
+            for (size_t d=0; d<_Parents.size();
+                ++d)
+            {// parents up to the root,
+                // at most one per code
+                auto F(_Parents.find(_Code));
+
+                if (F==_Parents.end())
+                    break;
+
+                _Code=F->second;
+
+                _Out.push_back(_Code);
+            }
+        }
+
+        /// @brief position of the field
+        /// in the microdata record
+        size_t
+            _Field;
+        /// @brief lengths of the prefixes
+        /// of the ancestors, increasing
+        std::vector<size_t>
+            _Levels;
+        /// @brief parent of each code
+        std::map<std::string,
+            std::string>
+            _Parents;
+    };
+
+    /// @brief type of the list of
+    /// hierarchies
+    typedef std::vector<
+        hierarchy_def>
+        hierarchy_list;
+
+    /// @brief convert a code to text.
+    template <class _ValTy>
+    inline auto code_string(
+        const _ValTy& _Val)
+        ->std::string
+    {
+        std::ostringstream _OSS;
+
+        _OSS << _Val;
+
+        return _OSS.str();
+    }
+
+    /// @brief convert text to a code.
+    /// @return false if not convertible.
+    template <class _ValTy>
+    inline bool code_value(
+        const std::string& _Str,
+        _ValTy& _Val)
+    {
+        std::istringstream _ISS(_Str);
+
+        _ISS >> _Val;
+
+        return ! _ISS.fail();
+    }
+
+    /// @brief convert text to a code
+    /// (strings, blanks included).
+    template <>
+    inline bool code_value(
+        const std::string& _Str,
+        std::string& _Val)
+    {
+        _Val=_Str;
+
+        return true;
+    }
+}
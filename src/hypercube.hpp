@@ -1,5 +1,7 @@
 #pragma once
 #include "nested_map.hpp"
+#include "lattice.hpp"
+#include "radix.hpp"
 
 namespace confly
 {
@@ -87,6 +89,134 @@ namespace confly
         }        
     };
 
+	/// @brief read the state of a
+	/// hypercube (see write_state_t).
+	template <size_t I, size_t M>
+	struct read_state_t
+    {
+		/// @brief read key, descent to
+		/// the next coordinate axis and
+		/// recurr.
+		/// @return false in case of read 
+		/// failure.
+		template <class _MapTy>
+        static bool read(
+            std::istream& _S,
+			_MapTy& _Cube)
+        {
+            typedef typename _MapTy
+                ::key_type
+                key_type;
+
+            key_type _Key; _S >> _Key;
+
+            if (! _S.good())
+                return false;
+
+            return read_state_t<I+1, M>
+                ::read(_S, _Cube[_Key]);
+        }
+    };
+
+	/// @brief read_state_t stop
+	template <size_t I>
+	struct read_state_t <I, I>
+    {
+		/// @brief read the state of the
+		/// response at cube's coordinates.
+		template <class _MapTy>
+        static bool read(
+            std::istream& _S,
+			_MapTy& _Response)
+        {
+            return _Response
+                .read_state(_S);
+        }        
+    };
+
+	/// @brief write the state of a
+	/// hypercube, i.e. the raw state
+	/// and the noise of each of its
+	/// cells, iterating its nested map.
+	template <size_t I, size_t M>
+	struct write_state_t
+	{
+		/// @brief store the coordinate in
+		/// the carry, descend and recurr.
+		template <
+			class _TupleTy,
+			class _MapTy>
+		static void write(
+			std::ostream& _S, 
+			char _Sep,
+			_TupleTy& _Carry,
+			const _MapTy& _Cube)
+		{
+			for (auto It=_Cube.cbegin(), 
+				E= _Cube.cend(); It!=E; 
+					++It)
+			{
+				std::get<I>(_Carry)
+                    =It->first;
+
+				write_state_t<I+1, M>
+					::write(_S, _Sep, 
+						_Carry, It->second);
+			}
+		}
+	};
+
+	/// @brief write_state_t stop
+	template <size_t I>
+	struct write_state_t <I, I>
+	{
+		/// @brief write coordinates
+		/// and state of the cell.
+		template <
+			class _TupleTy,
+			class _MapTy>
+		static void write(
+			std::ostream& _S, 
+			char _Sep,
+			_TupleTy& _Carry,
+			const _MapTy& _Response)
+		{
+			write_tuple<_TupleTy,1,I>(
+				_S, _Sep, _Carry);
+
+			_S.put(_Sep);
+
+			_Response.write_state(
+				_S, _Sep);
+
+			_S.put('\n');
+		}
+	};
+
+	// -------------------------------------
+
+	/// @brief append the Ith coordinate 
+	/// to the leading bits of a case.
+	/// @param _Val the coordinate.
+	/// @param _Bits leading bits of the
+	/// case (fields 1 to I-1).
+	/// @return the leading bits of the
+	/// case including the Ith field, whose
+	/// bit is set if the coordinate is
+	/// the total code.
+	template <size_t I, class _ValTy>
+	inline auto case_bits(
+		const _ValTy& _Val,
+		const lattice::case_type& _Bits)
+		->lattice::case_type
+	{
+		if (_Val==totcode<_ValTy>::get())
+			return _Bits | 
+				(lattice::case_type)1<<(I-1);
+
+		return _Bits;
+	}
+
 	// -------------------------------------
 
 	/// @brief iterate metadata, write 
@@ -110,6 +240,9 @@ namespace confly
 		/// do not already exist. This is useful
 		/// to fill the traversing nested map
 		/// in one single take.
+		/// Combinations leading to marginals
+		/// missing from the lattice are
+		/// skipped.
 		template <
 			class _MetaTy,
 			class _TupleTy,
@@ -118,6 +251,8 @@ namespace confly
 			const std::string& _cPath, 
 			char _Sep,
 			const _MetaTy& _Meta,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
 			_TupleTy& _Carry,
 			_MapTy& _Trv)
 		{// iterating metadata
@@ -128,6 +263,14 @@ namespace confly
 				E= _Set.cend(); It!=E; 
 					++It)
 			{
+				const lattice::case_type
+					_Next(case_bits<I>(
+						*It, _Bits));
+
+				if (! _Lattice.admits(
+					I, _Next))
+					continue;
+
 				// store coordinate in
 				// the carry 
 				std::get<I>(_Carry)=*It;
@@ -138,8 +281,9 @@ namespace confly
 				// recurr...
 				write_traversed_t<I+1, M>
 					::write(_cPath, _Sep, 
-						_Meta, _Carry,
-							_Map);
+						_Meta, _Lattice,
+							_Next, _Carry,
+								_Map);
 			}
 		}
 
@@ -158,6 +302,8 @@ namespace confly
 		static void write(
 			const std::string& _cPath, 
 			char _Sep,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
 			_TupleTy& _Carry,
 			const _MapTy& _Trv)
 		{// iterate the nested trav map
@@ -165,6 +311,14 @@ namespace confly
 				E= _Trv.cend(); It!=E; 
 					++It)
 			{
+				const lattice::case_type
+					_Next(case_bits<I>(
+						It->first, _Bits));
+
+				if (! _Lattice.admits(
+					I, _Next))
+					continue;
+
 				// store coordinate in
 				// the carry 
 				std::get<I>(_Carry)
@@ -177,7 +331,8 @@ namespace confly
 				// recurr...
 				write_traversed_t<I+1, M>
 					::write(_cPath, _Sep, 
-						_Carry, _Map);
+						_Lattice, _Next,
+							_Carry, _Map);
 			}
 		}
 	};
@@ -198,6 +353,8 @@ namespace confly
 			const std::string& _cPath, 
 			char _Sep,
 			const _MetaTy& _Meta,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
 			_TupleTy& _Carry,
 			_MapTy& _TrvResponse)
 		{
@@ -220,6 +377,8 @@ namespace confly
 		static void write(
 			const std::string& _cPath, 
 			char _Sep,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
 			_TupleTy& _Carry,
 			const _MapTy& _TrvResponse)
 		{
@@ -245,11 +404,13 @@ namespace confly
 			// create a filename to
 			// write the cell at
 			// '_Carry' coordinates
-			// e.g. trv_39_2_-1_-1.csv
+			// e.g. trv_39_2_-1_-1.csv,
+			// '_cPath' is the prefix 
+			// path/trv_ (see 
+			// hypercube::trv_prefix)
 			std::ostringstream 
 				_OSS; _OSS 
-				<< _cPath << CHARSL 
-                << OF_TRAV << CHARUS;
+				<< _cPath;
 				write_tuple<_TupleTy,1,I>(
 					_OSS, CHARUS, _Carry);
 				_OSS << DOT_CSV;
@@ -275,7 +436,9 @@ namespace confly
 		/// @brief Iterate metadata, descend 
 		/// both on cube and traversing maps 
 		/// coordinates, update carry and 
-		/// recurr.
+		/// recurr. Skip the coordinates 
+		/// leading to marginals missing from
+		/// the lattice.
 		template <
 			class _MetaTy,
 			class _TupleTy,
@@ -286,6 +449,8 @@ namespace confly
 			std::ostream& _S, 
 			const char& _Sep,
 			const _MetaTy& _Meta,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
 			_TupleTy& _Carry,
 			_MapTy& _Cube,
 			_TrvTy& _Trv)
@@ -297,6 +462,14 @@ namespace confly
 				E= _Set.cend(); It!=E; 
 					++It)
 			{
+				const lattice::case_type
+					_Next(case_bits<I>(
+						*It, _Bits));
+
+				if (! _Lattice.admits(
+					I, _Next))
+					continue;
+
 				std::get<I>(_Carry)=*It;
 
 				auto& _Map(_Cube[*It]);
@@ -305,14 +478,17 @@ namespace confly
 				write_cube<I+1, M>
 					::write(_CubeID, _S,
 						_Sep, _Meta, 
-							_Carry, _Map, 
-								_MapTrv);
+							_Lattice, _Next,
+								_Carry, _Map, 
+									_MapTrv);
 			}
 		}
 
 		/// @brief Iterate metadata, descend
 		/// only on cube maps coordinates,
-		/// update carry and recurr.
+		/// update carry and recurr. Skip the
+		/// coordinates leading to marginals
+		/// missing from the lattice.
 		template <
 			class _MetaTy,
 			class _TupleTy,
@@ -321,6 +497,8 @@ namespace confly
 			std::ostream& _S, 
 			const char& _Sep,
 			const _MetaTy& _Meta,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
 			_TupleTy& _Carry,
 			_MapTy& _Cube)
 		{// climb coords only on cube
@@ -331,6 +509,14 @@ namespace confly
 				E= _Set.cend(); It!=E; 
 					++It)
 			{
+				const lattice::case_type
+					_Next(case_bits<I>(
+						*It, _Bits));
+
+				if (! _Lattice.admits(
+					I, _Next))
+					continue;
+
 				std::get<I>(_Carry)=*It;
 
 				auto& _Map(_Cube[*It]);
@@ -338,7 +524,8 @@ namespace confly
 				write_cube<I+1, M>
 					::write(_S,
 						_Sep, _Meta, 
-							_Carry, _Map);
+							_Lattice, _Next,
+								_Carry, _Map);
 			}
 		}
 	};
@@ -361,6 +548,8 @@ namespace confly
 			std::ostream& _S, 
 			const char& _Sep,
 			const _MetaTy& _Meta,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
 			_TupleTy& _Carry,
 			_MapTy& _Response,
 			_TrvTy& _Traversed)
@@ -371,8 +560,10 @@ namespace confly
 
 			_S.put(_Sep);
 
-			// finalize response
-			_Response.finalize();
+			// finalize the requested
+			// mechanisms
+			_Response.finalize(
+				response::demand());
 
 			// update traversed
 			_Traversed.insert(
@@ -395,6 +586,8 @@ namespace confly
 			std::ostream& _S, 
 			const char&  _Sep,
 			const _MetaTy& _Meta,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
 			_TupleTy& _Carry,
 			_MapTy& _Response)
 		{
@@ -408,8 +601,10 @@ namespace confly
 
 			_S.put(_Sep);
 
-			// finalize response
-			_Response.finalize();
+			// finalize the requested
+			// mechanisms
+			_Response.finalize(
+				response::demand());
 
 			// write response
 			_Response.write(_S, _Sep);
@@ -418,6 +613,248 @@ namespace confly
 		}
 	};
 
+	/// @brief similar to write_cube, for
+	/// hypercubes stored as flat arrays of
+	/// cells (see struct cell_layout). The
+	/// offset of the cell is carried along
+	/// the recursion in place of the nested
+	/// map; the leaves are written by 
+	/// write_cube.
+	template <size_t I, size_t M>
+	struct write_flat
+	{
+		/// @brief Iterate metadata, add the
+		/// code of the coordinate to the
+		/// offset, descend the traversing map,
+		/// update carry and recurr. Skip the
+		/// coordinates leading to marginals
+		/// missing from the lattice.
+		template <
+			class _MetaTy,
+			class _TupleTy,
+			class _ShapeTy,
+			class _CellsTy,
+			class _TrvTy>
+		static void write(
+			const size_t& _CubeID,
+			std::ostream& _S, 
+			const char& _Sep,
+			const _MetaTy& _Meta,
+			const _ShapeTy& _Layout,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
+			const size_t& _Offset,
+			_TupleTy& _Carry,
+			_CellsTy& _Cells,
+			_TrvTy& _Trv)
+		{
+			const auto& _Set(
+				std::get<I>(_Meta));
+
+			size_t _Code(0);
+
+			for (auto It=_Set.cbegin(), 
+				E= _Set.cend(); It!=E; 
+					++It, ++_Code)
+			{
+				const lattice::case_type
+					_Next(case_bits<I>(
+						*It, _Bits));
+
+				if (! _Lattice.admits(
+					I, _Next))
+					continue;
+
+				std::get<I>(_Carry)=*It;
+
+				auto& _MapTrv(_Trv[*It]);
+
+				write_flat<I+1, M>
+					::write(_CubeID, _S,
+						_Sep, _Meta, _Layout,
+							_Lattice, _Next,
+								_Offset+_Code*
+								_Layout.stride(I-1),
+									_Carry, _Cells, 
+										_MapTrv);
+			}
+		}
+
+		/// @brief Iterate metadata, add the
+		/// code of the coordinate to the
+		/// offset, update carry and recurr.
+		/// Skip the coordinates leading to
+		/// marginals missing from the lattice.
+		template <
+			class _MetaTy,
+			class _TupleTy,
+			class _ShapeTy,
+			class _CellsTy>
+		static void write(
+			std::ostream& _S, 
+			const char& _Sep,
+			const _MetaTy& _Meta,
+			const _ShapeTy& _Layout,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
+			const size_t& _Offset,
+			_TupleTy& _Carry,
+			_CellsTy& _Cells)
+		{
+			const auto& _Set(
+				std::get<I>(_Meta));
+
+			size_t _Code(0);
+
+			for (auto It=_Set.cbegin(), 
+				E= _Set.cend(); It!=E; 
+					++It, ++_Code)
+			{
+				const lattice::case_type
+					_Next(case_bits<I>(
+						*It, _Bits));
+
+				if (! _Lattice.admits(
+					I, _Next))
+					continue;
+
+				std::get<I>(_Carry)=*It;
+
+				write_flat<I+1, M>
+					::write(_S, _Sep, 
+						_Meta, _Layout,
+							_Lattice, _Next,
+								_Offset+_Code*
+								_Layout.stride(I-1),
+									_Carry, _Cells);
+			}
+		}
+	};
+
+	/// @brief write_flat stop recursion
+	template <size_t I>
+	struct write_flat <I, I>
+	{
+		/// @brief write the cell at the
+		/// offset, update the traversing
+		/// structure.
+		template <
+			class _MetaTy,
+			class _TupleTy,
+			class _ShapeTy,
+			class _CellsTy,
+			class _TrvTy>
+		static void write(
+			const size_t& _CubeID,
+			std::ostream& _S, 
+			const char& _Sep,
+			const _MetaTy& _Meta,
+			const _ShapeTy&,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
+			const size_t& _Offset,
+			_TupleTy& _Carry,
+			_CellsTy& _Cells,
+			_TrvTy& _Traversed)
+		{
+			write_cube<I, I>
+				::write(_CubeID, _S, _Sep,
+					_Meta, _Lattice, _Bits,
+						_Carry, _Cells[_Offset],
+							_Traversed);
+		}
+
+		/// @brief write the cell at the
+		/// offset.
+		template <
+			class _MetaTy,
+			class _TupleTy,
+			class _ShapeTy,
+			class _CellsTy>
+		static void write(
+			std::ostream& _S, 
+			const char& _Sep,
+			const _MetaTy& _Meta,
+			const _ShapeTy&,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits,
+			const size_t& _Offset,
+			_TupleTy& _Carry,
+			_CellsTy& _Cells)
+		{
+			write_cube<I, I>
+				::write(_S, _Sep, _Meta, 
+					_Lattice, _Bits, _Carry, 
+						_Cells[_Offset]);
+		}
+	};
+
+	/// @brief count the cells written
+	/// by write_cube (and write_flat),
+	/// without iterating the metadata:
+	/// at each level, the codes of the
+	/// Ith field other than the total
+	/// one, and the total one.
+	template <size_t I, size_t M>
+	struct count_cells_t
+	{
+		/// @brief the cells below the
+		/// leading bits of a case.
+		template <class _MetaTy>
+		static auto count(
+			const _MetaTy& _Meta,
+			const lattice& _Lattice,
+			const lattice::case_type& _Bits)
+			->size_t
+		{
+			typedef typename std::decay<
+				decltype(std::get<I>(_Meta))
+					>::type::value_type 
+				value_type;
+
+			const auto& _Set(
+				std::get<I>(_Meta));
+
+			const size_t _Tot(_Set.count(
+				totcode<value_type>::get()));
+
+			size_t _Cells(0);
+
+			if (_Set.size()>_Tot &&
+				_Lattice.admits(I, _Bits))
+				_Cells+=(_Set.size()-_Tot)*
+				count_cells_t<I+1, M>::count(
+					_Meta, _Lattice, _Bits);
+
+			const lattice::case_type _Next(
+				_Bits | (lattice::case_type)
+					1<<(I-1));
+
+			if (_Tot && _Lattice.admits(
+				I, _Next))
+				_Cells+=count_cells_t<I+1, M>
+				::count(_Meta, _Lattice, 
+					_Next);
+
+			return _Cells;
+		}
+	};
+
+	/// @brief count_cells_t stop
+	template <size_t I>
+	struct count_cells_t <I, I>
+	{
+		template <class _MetaTy>
+		static auto count(
+			const _MetaTy&,
+			const lattice&,
+			const lattice::case_type&)
+			->size_t
+		{
+			return 1;
+		}
+	};
+
 	/// @brief updates the response
 	/// found as leaf of a nested map
 	/// at specific coordinates.
@@ -431,10 +868,11 @@ namespace confly
 			class _DstTy>
 		static void update(
 			const _SrcTy& _Src,
+			const record_contrib& _Contrib,
 			_DstTy& _Dst)
 		{
 			update_t<I+1, M>
-			::update(_Src, 
+			::update(_Src, _Contrib,
 				_Dst[std::get<I>(
 					_Src)]);
 		}
@@ -444,36 +882,276 @@ namespace confly
 	template <size_t I>
 	struct update_t <I, I>
 	{
-		/// @brief draw record-key
-		/// for cell-key method, 
-		/// call update() on the
-		/// leaf.
+		/// @brief pass the record-key
+		/// for cell-key method (and the
+		/// magnitude), call update() on
+		/// the leaf.
 		template <class _SrcTy, 
 			class _DstTy>
 		static void update(
-			const _SrcTy& _Src,
+			const _SrcTy&,
+			const record_contrib& _Contrib,
 			_DstTy& _Dst)
 		{                
-			const double
-				_RKey(rkey(_Src));
-
 			// pass rkey to the 
 			// response of the cell
-			_Dst.update(_RKey);
+			_Dst.update(_Contrib);
 		}
+	};
 
-	private:
+	/// @brief merge a partial nested
+	/// map into another one, recurring
+	/// coordinate by coordinate.
+	template <size_t I, size_t M>
+	struct merge_t
+	{
+		/// @brief iterate the source map,
+		/// descend both maps at the same
+		/// key and recurr.
+		/// @param _Src partial nested map.
+		/// @param _Dst destination nested
+		/// map; missing buckets are created.
+		template <class _MapTy>
+		static void merge(
+			const _MapTy& _Src,
+			_MapTy& _Dst)
+		{
+			for (auto It=_Src.cbegin(),
+				E=_Src.cend(); It!=E;
+					++It)
+			{
+				merge_t<I+1, M>
+				::merge(It->second,
+					_Dst[It->first]);
+			}
+		}
+	};
+
+	/// @brief merge_t stop recursion
+	template <size_t I>
+	struct merge_t <I, I>
+	{
+		/// @brief merge the leaf
+		/// responses.
+		template <class _RespTy>
+		static void merge(
+			const _RespTy& _Src,
+			_RespTy& _Dst)
+		{
+			_Dst.merge(_Src);
+		}
+	};
+
+	/// @brief get the case (see struct
+	/// lattice) of a set of coordinates.
+	template <size_t I, size_t M>
+	struct case_t
+	{
+		/// @brief append the bit of the
+		/// Ith coordinate and recurr.
+		template <class _SrcTy>
+		static auto get(
+			const _SrcTy& _Src,
+			const lattice::case_type& _Bits)
+			->lattice::case_type
+		{
+			return case_t<I+1, M>::get(
+				_Src, case_bits<I>(
+					std::get<I>(_Src), 
+						_Bits));
+		}
+	};
 
+	/// @brief case_t stop recursion
+	template <size_t I>
+	struct case_t <I, I>
+	{
+		/// @brief return the case.
 		template <class _SrcTy>
-		static double rkey(
-			const _SrcTy& _Src)
-		{// convert rkey to real
-			static const double
-				_DREMAX(_DRE.max());
+		static auto get(
+			const _SrcTy&,
+			const lattice::case_type& _Bits)
+			->lattice::case_type
+		{
+			return _Bits;
+		}
+	};
 
-			return (double)
-				std::get<0>(_Src)/
-					_DREMAX;
+	/// @brief locate the leaf of a 
+	/// nested map at specific 
+	/// coordinates.
+	template <size_t I, size_t M>
+	struct locate_t
+	{
+		/// @brief descend the nested map
+		/// at the Ith coordinate and recurr;
+		/// the missing buckets are created.
+		template <
+			class _SrcTy,
+			class _MapTy,
+			class _LeafTy>
+		static void at(
+			const _SrcTy& _Src,
+			_MapTy& _Map,
+			_LeafTy*& _Leaf)
+		{
+			locate_t<I+1, M>::at(_Src,
+				_Map[std::get<I>(_Src)],
+					_Leaf);
+		}
+	};
+
+	/// @brief locate_t stop recursion
+	template <size_t I>
+	struct locate_t <I, I>
+	{
+		/// @brief point to the leaf.
+		template <
+			class _SrcTy,
+			class _MapTy,
+			class _LeafTy>
+		static void at(
+			const _SrcTy&,
+			_MapTy& _Map,
+			_LeafTy*& _Leaf)
+		{
+			_Leaf=&_Map;
+		}
+	};
+
+	/// @brief copy the cells of a nested
+	/// map, along with their coordinates.
+	template <size_t I, size_t M>
+	struct collect_t
+	{
+		/// @brief iterate the nested map,
+		/// update carry and recurr.
+		template <
+			class _MapTy,
+			class _TupleTy,
+			class _CellsTy>
+		static void collect(
+			const _MapTy& _Map,
+			_TupleTy& _Carry,
+			_CellsTy& _Cells)
+		{
+			for (auto It=_Map.cbegin(),
+				E=_Map.cend(); It!=E;
+					++It)
+			{
+				std::get<I>(_Carry)=
+					It->first;
+
+				collect_t<I+1, M>
+					::collect(It->second,
+						_Carry, _Cells);
+			}
+		}
+	};
+
+	/// @brief collect_t stop recursion
+	template <size_t I>
+	struct collect_t <I, I>
+	{
+		/// @brief append the cell.
+		template <
+			class _RespTy,
+			class _TupleTy,
+			class _CellsTy>
+		static void collect(
+			const _RespTy& _Response,
+			_TupleTy& _Carry,
+			_CellsTy& _Cells)
+		{
+			_Cells.push_back(std::make_pair(
+				_Carry, _Response));
+		}
+	};
+
+	/// @brief sum up the cells of the
+	/// ancestors of the fields declaring
+	/// a hierarchy (see micro::
+	/// set_hierarchies()) from the cells
+	/// of their leaves.
+	template <size_t I, size_t M>
+	struct roll_up_t
+	{
+		/// @brief roll the Ith field up
+		/// and recurr. The cells of the
+		/// ancestors of the previous fields
+		/// are rolled up as well, so that
+		/// all the combinations of levels
+		/// are summed up.
+		template <
+			class _TupleTy,
+			class _AncTy,
+			class _MapTy>
+		static void roll(
+			const _AncTy& _Anc,
+			_MapTy& _Cube)
+		{
+			const auto& _Map(
+				std::get<I>(_Anc));
+
+			if (! _Map.empty())
+			{// copy the cells first, as
+				// the ancestors' ones are
+				// inserted
+				std::vector<std::pair<
+					_TupleTy, response>> _Cells;
+
+				_TupleTy _Carry;
+
+				collect_t<1, M>::collect(
+					_Cube, _Carry, _Cells);
+
+				for (size_t c=0; c<_Cells
+					.size(); ++c)
+				{
+					auto F(_Map.find(std::get<I>(
+						_Cells[c].first)));
+
+					if (F==_Map.end())
+						continue;
+
+					for (size_t a=0; a<F->second
+						.size(); ++a)
+					{
+						_TupleTy _Tup(
+							_Cells[c].first);
+
+						std::get<I>(_Tup)=
+							F->second[a];
+
+						response* _Cell(0);
+
+						locate_t<1, M>::at(
+							_Tup, _Cube, _Cell);
+
+						_Cell->merge(
+							_Cells[c].second);
+					}
+				}
+			}
+
+			roll_up_t<I+1, M>::template
+				roll<_TupleTy>(_Anc, _Cube);
+		}
+	};
+
+	/// @brief roll_up_t stop recursion
+	template <size_t I>
+	struct roll_up_t <I, I>
+	{
+		/// @brief roll_up_t stop
+		template <
+			class _TupleTy,
+			class _AncTy,
+			class _MapTy>
+		static void roll(
+			const _AncTy&,
+			_MapTy&)
+		{
 		}
 	};
 
@@ -483,7 +1161,7 @@ namespace confly
 		class _DstTy>
 	inline void update_totals(
 		const _SrcTy& _Src,
-		const size_t& _Mask,
+		const lattice& _Lattice,
 		_DstTy& _Dst)
 	{
 		// call stack
@@ -492,34 +1170,72 @@ namespace confly
 		typedef std::tuple_size<_SrcTy>
 			_TupSzTy;
 
-		// static const size_t 
-		// 	_TupleSz(std::tuple_size<
-		// 		_SrcTy>::value);
+		// iterate only the marginals
+		// of the lattice (masked cells
+		// as defined with "cube=false"
+		// in the configuration file
+		// are already excluded)
+		const lattice::container& 
+			_Cases(_Lattice.cases());
 
-		// exclude 'id' from the 
-		// possible combinations
-		static const size_t 
-			_Cases(std::pow(2, 
-				_TupSzTy::value-1));
+		// taken before the fields are
+		// replaced by their total codes
+		const record_contrib _Contrib(
+			make_contrib(_Src));
 
-		for (size_t i=0; i<_Cases;
+		for (size_t i=0; i<_Cases.size();
 			++i)
 		{
-			// skip updates to masked cells
-			// as defined with "cube=false"
-			// in the configuration file
-			if (i != (i|_Mask))
-				continue;
-
 			_SrcTy _Tup(_Src);
 
 			conditional_set_tuple<
 				totcode,
 				1, _TupSzTy::value>
-				::set(i, _Tup);
+				::set(_Cases[i], _Tup);
 
 			update_t<1, _TupSzTy::value>
-				:: update(_Tup, _Dst);
+				:: update(_Tup, _Contrib, 
+					_Dst);
+		}
+	}
+
+	/// @brief update cube cells with a
+	/// run of records in the same finest
+	/// cell, aggregated beforehand.
+	/// @param _Src the first record of 
+	/// the run.
+	/// @param _Run the response aggregating
+	/// the records of the run.
+	template <class _SrcTy, 
+		class _DstTy>
+	inline void merge_totals(
+		const _SrcTy& _Src,
+		const response& _Run,
+		const lattice& _Lattice,
+		_DstTy& _Dst)
+	{
+		typedef std::tuple_size<_SrcTy>
+			_TupSzTy;
+
+		const lattice::container& 
+			_Cases(_Lattice.cases());
+
+		for (size_t i=0; i<_Cases.size();
+			++i)
+		{
+			_SrcTy _Tup(_Src);
+
+			conditional_set_tuple<
+				totcode,
+				1, _TupSzTy::value>
+				::set(_Cases[i], _Tup);
+
+			response* _Cell(0);
+
+			locate_t<1, _TupSzTy::value>
+				::at(_Tup, _Dst, _Cell);
+
+			_Cell->merge(_Run);
 		}
 	}
 
@@ -537,6 +1253,10 @@ namespace confly
 		virtual void set_id(
 			const size_t&) =0;
 
+		/// @brief set cube ordinal
+		virtual void set_ordinal(
+			const size_t&) =0;
+
 		/// @brief read from stream
         virtual bool read(
             std::istream&) =0;
@@ -544,7 +1264,19 @@ namespace confly
 		/// @brief write cubes and
 		/// traverse in one go
 		virtual void write_traversing(
-			const std::string&) =0;
+			const std::string&,
+			const std::string&,
+			const lattice::container&) =0;
+
+		/// @brief read the state saved
+		/// by a previous run
+		virtual bool read_state(
+            std::istream&) =0;
+
+		/// @brief save the state for
+		/// the next delta run
+		virtual void write_state(
+            std::ostream&) =0;
 	};
 
 	/// @brief second base class
@@ -622,6 +1354,12 @@ namespace confly
 			micro_type::tuple_type
 			branch_type;
 
+		/// @brief type of the container
+		/// of micro's records.
+		typedef typename
+			micro_type::container
+			container;
+
 		/// @brief type of the tuple_size
 		/// of the micro's records.
 		typedef typename
@@ -641,7 +1379,7 @@ namespace confly
 			metadata_size;
 
 		/// @brief construct empty
-		hypercube() : _ID(0) {}
+		hypercube() : _ID(0), _Ordinal(0) {}
 
 		/// @brief destroy
 		~ hypercube() {}
@@ -655,15 +1393,181 @@ namespace confly
 			_ID=_cID;
 		}
 
+		/// @brief get ID
+		auto get_id() const
+			->const size_t&
+		{
+			return _ID;
+		}
+
+		/// @brief set the ordinal of the
+		/// cube among all the cubes of
+		/// the run, keying its draws.
+		/// @note the ID is the position
+		/// of the cube among the cubes
+		/// traversed by this machine.
+		virtual void set_ordinal(
+			const size_t& _cOrdinal)
+		{
+			_Ordinal=_cOrdinal;
+		}
+
+		/// @brief get ordinal
+		auto get_ordinal() const
+			->const size_t&
+		{
+			return _Ordinal;
+		}
+
 		/// @brief update cube with
 		/// the supplied record, depending
-		/// on the mask.
+		/// on the lattice.
 		void update(
-			const size_t& _Mask,
+			const lattice& _Lattice,
 			const branch_type& _Tup)
 		{            
 			update_totals(
-				_Tup, _Mask, _Cube);
+				_Tup, _Lattice, _Cube);
+		}
+
+		/// @brief update cube with the
+		/// sampled records, splitting the
+		/// records into contiguous ranges
+		/// aggregated in parallel.
+		/// @param _Lattice the lattice.
+		/// @param _Vec the microdata records.
+		/// @param _Marks sampled flags, one
+		/// for each microdata record.
+		/// @param _Threads number of ranges
+		/// (and threads) to split into.
+		/// @param _Starts flags of the records
+		/// starting a run in the same finest
+		/// cell (see micro::sort()), empty if
+		/// the records are not sorted.
+		/// @note each range is aggregated
+		/// into its own partial nested map,
+		/// then the partial maps are merged
+		/// in range order. Since counts and
+		/// record keys are summed as integers
+		/// the result is identical to the
+		/// serial aggregation (so are the
+		/// sums of an integral magnitude
+		/// field; the sums of a real one may
+		/// differ in the last digits).
+		/// @note with sorted records, the 
+		/// sampled records of each run are 
+		/// accumulated first, and the cells
+		/// updated once per run.
+		void update(
+			const lattice& _Lattice,
+			const container& _Vec,
+			const std::vector<bool>& _Marks,
+			const size_t& _Threads,
+			const std::vector<bool>& _Starts)
+		{
+			const size_t 
+				_RecordsSz(_Vec.size()),
+				_Parts(std::max<size_t>(1, 
+					std::min(_Threads, 
+						_RecordsSz)));
+
+			// range 0 updates the cube,
+			// the others a partial map
+			std::vector<nested_map_type>
+				_Partials(_Parts-1);
+
+			#pragma omp parallel for \
+				num_threads(_Parts) \
+				schedule(static, 1)
+			for (size_t p=0; p<_Parts; 
+				++p)
+			{
+				nested_map_type& _Dst(
+					0==p ? _Cube : 
+						_Partials[p-1]);
+
+				const size_t
+					_Beg(_RecordsSz*p/_Parts),
+					_End(_RecordsSz*(p+1)/_Parts);
+
+				if (_Starts.empty())
+				for (size_t i=_Beg; i<_End;
+					++i)
+				{
+					if (_Marks[i])
+						update_totals(
+							_Vec[i], _Lattice, 
+								_Dst);
+				}
+
+				else // run-length
+				update_runs(_Lattice, _Vec,
+					_Marks, _Starts, _Beg, 
+						_End, _Dst);
+			}
+
+			// merge in range order
+			for (size_t p=0; p<_Partials
+				.size(); ++p)
+			{
+				merge_t<1, branch_size::value>
+					::merge(_Partials[p], 
+						_Cube);
+			}
+		}
+
+		/// @brief update the flat cube
+		/// with the sampled records, using
+		/// the radix-partitioned aggregation
+		/// (see struct radix_aggregator).
+		/// @param _Layout the cube layout.
+		/// @param _Shape the shape, either
+		/// the layout itself or a fixed_shape
+		/// matching it.
+		/// @param _Codes the packed codes and
+		/// keys of the records.
+		/// @param _Lattice the lattice.
+		/// @param _Marks sampled flags, one
+		/// for each microdata record.
+		/// @param _Threads number of threads.
+		/// @note the cells are allocated here
+		/// and released by the flat write().
+		template <class _ShapeTy>
+		void update(
+			const cell_layout& _Layout,
+			const _ShapeTy& _Shape,
+			const packed_columns& _Codes,
+			const lattice& _Lattice,
+			const std::vector<bool>& _Marks,
+			const size_t& _Threads)
+		{
+			_Cells.assign(
+				_Shape.size(), 
+					response());
+
+			radix_aggregator<response, 
+				_ShapeTy>(_Layout, _Shape, 
+					_Codes, _Lattice)
+				.update(_Marks, _Threads,
+					_Cells);
+		}
+
+		/// @brief sum up the cells of the
+		/// ancestors of the fields declaring
+		/// a hierarchy from the cells of
+		/// their leaves, once aggregated,
+		/// instead of aggregating the records
+		/// once per level.
+		/// @param _Anc the ancestors of the
+		/// values of each field (see micro::
+		/// get_ancestry()).
+		template <class _AncTy>
+		void roll_up(
+			const _AncTy& _Anc)
+		{
+			roll_up_t<1, branch_size::value>
+				::template roll<branch_type>(
+					_Anc, _Cube);
 		}
 
 		/// @brief read from stream
@@ -701,13 +1605,65 @@ namespace confly
             return true;
         }
 
+		/// @brief read the state saved by
+		/// write_state() into the nested 
+		/// map.
+		/// @note the cells read keep their
+		/// noise, unless updated again.
+        virtual bool read_state(
+            std::istream& _S)
+        {
+            while(_S.good())
+            {
+                std::string _L;
+
+                std::getline(_S, _L);
+
+                if (_L.size()<
+                    sizeof...(_Types))
+                    continue;
+
+                std::replace(_L.begin(),
+                    _L.end(), CHARSC, 
+                        CHARSP);
+
+                std::istringstream 
+                    _ISS(_L);
+
+                if (! read_state_t<0, 
+                    branch_size::value-1>
+                    ::read(_ISS, _Cube))
+                        return false;
+            }
+
+            return true;
+        }
+
+		/// @brief write the state of the
+		/// nested map, once written (i.e.
+		/// finalized), one cell per line:
+		/// coordinates, record key sum and
+		/// record (see response::write_state).
+        virtual void write_state(
+            std::ostream& _S)
+        {
+			branch_type _Carry;
+
+			write_state_t<
+				1, metadata_size::value>
+				::write(_S, CHARSC,
+					_Carry, _Cube);
+        }
+
 		/// @brief write to stream.
 		/// @param _Meta the metadata.
+		/// @param _Lattice the lattice.
 		/// @param _S the output stream.
 		/// @param _BNoTrav if true, do
 		/// not perform traversing in one go.
 		void write(
 			const metadata& _Meta,
+			const lattice& _Lattice,
 			std::ostream& _S,
 			bool _BNoTrav)  
 		{// finalize cubes and traverse 
@@ -719,56 +1675,278 @@ namespace confly
 			write_cube<
 				1, metadata_size::value>
 				::write(_S, CHARSC, 
-					_Meta, _Carry, 
-						_Cube);
+					_Meta, _Lattice, 0,
+						_Carry, _Cube);
 
 			else // traverse as well
 			write_cube<
 				1, metadata_size::value>
 				::write(_ID, _S, CHARSC, 
-					_Meta, _Carry, 
-						_Cube, _Trv);
+					_Meta, _Lattice, 0,
+						_Carry, _Cube, _Trv);
+		}
+
+		/// @brief write to stream only the
+		/// cells with support in the
+		/// microdata, in the same order as
+		/// the write() iterating the metadata;
+		/// the other combinations of the 
+		/// metadata are structural zeros,
+		/// neither allocated nor written.
+		/// @param _Support the coordinates
+		/// of the cells with support (see
+		/// micro::build_support()).
+		/// @param _Lattice the lattice.
+		/// @param _S the output stream.
+		/// @param _BNoTrav if true, do
+		/// not perform traversing in one go.
+		/// @note the cells with support not
+		/// sampled by this cube are inserted,
+		/// so that their noise is kept by the
+		/// saved state (see write_state()).
+		template <class _SupportTy>
+		void write(
+			const _SupportTy& _Support,
+			const lattice& _Lattice,
+			std::ostream& _S,
+			bool _BNoTrav)  
+		{
+			for (auto It=_Support.cbegin(),
+				E=_Support.cend(); It!=E;
+					++It)
+			{
+				if (! _Lattice.admits(
+					_Lattice.width(),
+					case_t<1, metadata_size
+						::value>::get(*It, 0)))
+					continue;
+
+				response* _Response(0);
+
+				locate_t<1, metadata_size
+					::value>::at(*It, _Cube, 
+						_Response);
+
+				// write branch (skip 1st)
+				write_tuple<branch_type, 1,
+					metadata_size::value>(
+						_S, CHARSC, *It);
+
+				_S.put(CHARSC);
+
+				_Response->finalize(
+					response::demand());
+
+				if (! _BNoTrav)
+				{// update traversed
+					traversed_response* 
+						_Traversed(0);
+
+					locate_t<1, metadata_size
+						::value>::at(*It, _Trv, 
+							_Traversed);
+
+					_Traversed->insert(_ID,
+						_Response->get());
+				}
+
+				_Response->write(_S, CHARSC);
+
+				_S.put('\n');
+			}
+		}
+
+		/// @brief write the flat cube
+		/// to stream (see release()).
+		/// @param _Meta the metadata.
+		/// @param _Layout the shape of the
+		/// cube (see update()).
+		/// @param _Lattice the lattice.
+		/// @param _S the output stream.
+		/// @param _BNoTrav if true, do
+		/// not perform traversing in one go.
+		template <class _ShapeTy>
+		void write(
+			const metadata& _Meta,
+			const _ShapeTy& _Layout,
+			const lattice& _Lattice,
+			std::ostream& _S,
+			bool _BNoTrav)  
+		{
+			branch_type _Carry;
+
+			if (_BNoTrav)
+			write_flat<
+				1, metadata_size::value>
+				::write(_S, CHARSC, 
+					_Meta, _Layout, _Lattice, 
+						0, 0, _Carry, _Cells);
+
+			else // traverse as well
+			write_flat<
+				1, metadata_size::value>
+				::write(_ID, _S, CHARSC, 
+					_Meta, _Layout, _Lattice, 
+						0, 0, _Carry, _Cells, 
+							_Trv);
+		}
+
+		/// @brief release the cells of
+		/// the flat cube, once written
+		/// to all the tables.
+		void release()
+		{
+			std::vector<response>()
+				.swap(_Cells);
+		}
+
+		/// @brief get the number of cells
+		/// write() finalizes, known before
+		/// the cube is aggregated.
+		/// @param _Meta the metadata.
+		/// @param _Lattice the lattice.
+		static auto cells(
+			const metadata& _Meta,
+			const lattice& _Lattice)
+			->size_t
+		{
+			return count_cells_t<
+				1, metadata_size::value>
+				::count(_Meta, _Lattice, 0);
 		}
 
 		/// @brief iterate the metadata
 		/// and write the traversing files
 		/// @param _Meta the metadata.
+		/// @param _Lattice the lattice of
+		/// the table.
 		/// @param _cPath the path to write the
 		/// traversing files.
+		/// @param _Name the name of the
+		/// table, empty if unnamed.
 		static void write_traversing(
 			const metadata& _Meta,
-			const std::string& _cPath)
+			const lattice& _Lattice,
+			const std::string& _cPath,
+			const std::string& _Name)
 		{
 			branch_type _Carry;
 
 			write_traversed_t<
 				1, metadata_size::value>
-				::write(_cPath, CHARSC,
-					_Meta, _Carry, _Trv);
+				::write(trv_prefix(_cPath, 
+					_Name), CHARSC,
+					_Meta, _Lattice, 0,
+						_Carry, _Trv);
 		}
 
 		/// @brief iterate the nested map
-		/// and write the traversing files
+		/// and write the traversing files,
+		/// i.e. only the cells written by
+		/// the cubes (see the write() of the
+		/// cells with support).
+		/// @param _Lattice the lattice of
+		/// the table.
 		/// @param _cPath the path to write the
 		/// traversing files.
-		virtual void write_traversing(
-			const std::string& _cPath)
-		{// write the traversing files
-            // iterating trv
+		/// @param _Name the name of the
+		/// table, empty if unnamed.
+		static void write_traversing(
+			const lattice& _Lattice,
+			const std::string& _cPath,
+			const std::string& _Name)
+		{
 			branch_type _Carry;
 
 			write_traversed_t<
 				1, metadata_size::value>
-				::write(_cPath, CHARSC,
-					_Carry, _Trv);
+				::write(trv_prefix(_cPath, 
+					_Name), CHARSC,
+					_Lattice, 0, _Carry, 
+						_Trv);
+		}
+
+		/// @brief iterate the nested map
+		/// and write the traversing files
+		/// @param _cPath the path to write the
+		/// traversing files.
+		/// @param _Name the name of the
+		/// table, empty if unnamed.
+		/// @param _Cases the marginals of
+		/// the table.
+		virtual void write_traversing(
+			const std::string& _cPath,
+			const std::string& _Name,
+			const lattice::container& _Cases)
+		{// write the traversing files
+            // iterating trv
+			write_traversing(lattice(
+				metadata_size::value-1, 
+					_Cases), _cPath, _Name);
 		}
 
 	private:
 
+		/// @brief update the cube with the
+		/// sampled records of a range of 
+		/// sorted records, once per run.
+		void update_runs(
+			const lattice& _Lattice,
+			const container& _Vec,
+			const std::vector<bool>& _Marks,
+			const std::vector<bool>& _Starts,
+			const size_t& _Beg,
+			const size_t& _End,
+			nested_map_type& _Dst)
+		{
+			response _Run;
+
+			size_t _Head(_End);
+
+			for (size_t i=_Beg; i<_End; ++i)
+			{
+				if (_Starts[i] && _Head!=_End)
+				{// flush the previous run
+					merge_totals(_Vec[_Head],
+						_Run, _Lattice, _Dst);
+
+					_Run=response();
+					_Head=_End;
+				}
+
+				if (! _Marks[i])
+					continue;
+
+				if (_Head==_End)
+					_Head=i;
+
+				_Run.update(make_contrib(
+					_Vec[i]));
+			}
+
+			if (_Head!=_End)
+				merge_totals(_Vec[_Head],
+					_Run, _Lattice, _Dst);
+		}
+
+		static auto trv_prefix(
+			const std::string& _cPath,
+			const std::string& _Name)
+			->std::string
+		{// path/trv_ or path/trv_name_
+			return table_fname(_cPath 
+				+ CHARSL + OF_TRAV 
+				+ CHARUS, _Name);
+		}
+
 		size_t 
 			_ID;
+		size_t
+			_Ordinal;
 		nested_map_type
 			_Cube;
+		std::vector<response>
+			_Cells;
 		static traversing_nested_map_type
 			_Trv;
 	};    
@@ -0,0 +1,200 @@
+#pragma once
+#include <set>
+#include <string>
+#include <vector>
+
+namespace confly
+{
+    /// @brief the lattice of the marginal
+    /// tables materialized in the hypercubes.
+    /// @note each marginal is identified by
+    /// a case, i.e. a bit mask of the fields
+    /// replaced by their total codes: the
+    /// bit at position I-1 stands for the
+    /// Ith field of the microdata record
+    /// (the record ID at position 0 is
+    /// excluded). The case 0 identifies the
+    /// most detailed table, the case with
+    /// all the bits set the grand total.
+    struct lattice
+    {
+        /// @brief type of a case
+        typedef size_t
+            case_type;
+
+        /// @brief type of the container
+        /// of cases
+        typedef std::vector<
+            case_type>
+            container;
+
+        /// @brief construct empty.
+        lattice()
+            : _Width(0)
+            , _Cases()
+            , _Prefixes()
+        {
+        }
+
+        /// @brief construct with parameters.
+        /// @param _cWidth number of fields
+        /// (record ID excluded).
+        /// @param _cCases the cases to
+        /// materialize.
+        lattice(
+            const size_t& _cWidth,
+            const container& _cCases)
+            : _Width(_cWidth)
+            , _Cases(_cCases)
+            , _Prefixes(_cWidth+1)
+        {
+            for (size_t i=0; i<_Cases.size();
+                ++i)
+            {// store the leading bits
+                // of each case, level by
+                // level
+                for (size_t L=0; L<=_Width;
+                    ++L)
+                {
+                    _Prefixes[L].insert(
+                        _Cases[i]&low_bits(L));
+                }
+            }
+        }
+
+        /// @brief get the cases.
+        /// @return const reference to the
+        /// vector of cases, in increasing
+        /// order.
+        auto cases() const
+            ->const container&
+        {
+            return _Cases;
+        }
+
+        /// @brief get the number of fields
+        /// (record ID excluded).
+        auto width() const
+            ->const size_t&
+        {
+            return _Width;
+        }
+
+        /// @brief test whether at least one
+        /// case starts with the supplied
+        /// leading bits.
+        /// @param _Level number of leading
+        /// fields already decided (bits 0 to
+        /// _Level-1 of the prefix).
+        /// @param _Prefix the leading bits.
+        /// @return true if the prefix leads
+        /// to at least one materialized
+        /// marginal, false otherwise.
+        /// @note used to prune the iteration
+        /// of the metadata when finalizing
+        /// and traversing the hypercubes.
+        bool admits(
+            const size_t& _Level,
+            const case_type& _Prefix)
+            const
+        {
+            if (_Level>=_Prefixes.size())
+                return false;
+
+            return _Prefixes[_Level]
+                .count(_Prefix)>0;
+        }
+
+        /// @brief get the number of fields
+        /// not replaced by total codes.
+        /// @param _Case the case.
+        /// @param _Width number of fields.
+        static auto order(
+            const case_type& _Case,
+            const size_t& _Width)
+            ->size_t
+        {
+            size_t _Order(0);
+
+            for (size_t b=0; b<_Width;
+                ++b)
+            {
+                if (! (_Case &
+                    ((case_type)1<<b)))
+                    ++_Order;
+            }
+
+            return _Order;
+        }
+
+        /// @brief get all the cases compatible
+        /// with the supplied mask, i.e. all
+        /// the combinations of total codes
+        /// where the masked fields are always
+        /// replaced by their total codes.
+        /// @param _Width number of fields.
+        /// @param _Mask bit mask of the fields
+        /// to aggregate only.
+        /// @param _Out destination vector.
+        static void full(
+            const size_t& _Width,
+            const case_type& _Mask,
+            container& _Out)
+        {
+            const case_type _Cases(
+                (case_type)1<<_Width);
+
+            _Out.clear();
+
+            for (case_type i=0; i<_Cases;
+                ++i)
+            {
+                if (i == (i|_Mask))
+                    _Out.push_back(i);
+            }
+        }
+
+    private:
+
+        static auto low_bits(
+            const size_t& _Level)
+            ->case_type
+        {
+            return ((case_type)1
+                <<_Level)-1;
+        }
+
+        size_t
+            _Width;
+        container
+            _Cases;
+        std::vector<std::set<
+            case_type>>
+            _Prefixes;
+    };
+
+    /// @brief a table to publish: its
+    /// name and the marginals of its
+    /// variables (see config "tables").
+    /// @note all the tables of a run are
+    /// aggregated into the same hypercube,
+    /// whose lattice is the union of the
+    /// tables' ones, and written to their
+    /// own files.
+    struct table_def
+    {
+        /// @brief name, used to namespace
+        /// the output files (empty when no
+        /// tables are configured).
+        std::string
+            _Name;
+        /// @brief cases of the marginals
+        lattice::container
+            _Cases;
+    };
+
+    /// @brief type of the list of tables
+    typedef std::vector<
+        table_def>
+        table_list;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -7,9 +8,301 @@
 #include "shared.hpp"
 #include "tuples.hpp"
 #include "random_dist.hpp"
+#include "lattice.hpp"
+#include "hierarchy.hpp"
+#include "radix.hpp"
 
 namespace confly
 {
+    /// @brief dictionary encode the
+    /// fields of the microdata records
+    /// using the metadata.
+    template <size_t I, size_t M>
+    struct encode_t
+    {
+        /// @brief encode the Ith field
+        /// and recurr.
+        /// @param _Meta the metadata.
+        /// @param _Vec the records.
+        /// @param _Mask the mask; masked
+        /// fields are encoded as totals.
+        /// @param _Cards destination
+        /// cardinalities.
+        /// @param _Totals destination codes
+        /// of the totals.
+        /// @param _Codes destination packed
+        /// code columns.
+        template <
+            class _MetaTy,
+            class _VecTy>
+        static void encode(
+            const _MetaTy& _Meta,
+            const _VecTy& _Vec,
+            const size_t& _Mask,
+            std::vector<size_t>& _Cards,
+            std::vector<cell_code_type>& 
+                _Totals,
+            packed_columns& _Codes)
+        {
+            typedef typename 
+                std::tuple_element<I, 
+                    _MetaTy>::type
+                    ::value_type
+                value_type;
+
+            // sorted as the set
+            const auto& _Set(
+                std::get<I>(_Meta));
+
+            const std::vector<value_type>
+                _Dict(_Set.begin(), 
+                    _Set.end());
+
+            const cell_code_type _Tot(
+                std::lower_bound(
+                    _Dict.begin(), 
+                    _Dict.end(),
+                    totcode<value_type>
+                        ::get())
+                - _Dict.begin());
+
+            _Cards[I-1]=_Dict.size();
+            _Totals[I-1]=_Tot;
+
+            std::vector<cell_code_type>
+                _Col(_Vec.size());
+
+            const bool _BMasked(
+                _Mask & (size_t)1<<(I-1));
+
+            for (size_t i=0; i<_Vec.size();
+                ++i)
+            {
+                _Col[i]=_BMasked ? _Tot : 
+                    std::lower_bound(
+                        _Dict.begin(), 
+                        _Dict.end(),
+                        std::get<I>(_Vec[i]))
+                    - _Dict.begin();
+            }
+
+            _Codes.assign(I-1, 
+                _Dict.size(), _Col);
+
+            encode_t<I+1, M>
+                ::encode(_Meta, _Vec, 
+                    _Mask, _Cards, 
+                        _Totals, _Codes);
+        }
+    };
+
+    /// @brief encode_t stop recursion
+    template <size_t I>
+    struct encode_t <I, I>
+    {
+        /// @brief encode_t stop
+        template <
+            class _MetaTy,
+            class _VecTy>
+        static void encode(
+            const _MetaTy&,
+            const _VecTy&,
+            const size_t&,
+            std::vector<size_t>&,
+            std::vector<cell_code_type>&,
+            packed_columns&)
+        {
+        }
+    };
+
+    /// @brief order the indices of the
+    /// microdata records by the coordinates
+    /// of their finest cell, i.e. by their
+    /// fields not masked.
+    template <class _VecTy>
+    struct coords_less
+    {
+        /// @brief the type of the record
+        typedef typename 
+            _VecTy::value_type
+            tuple_type;
+
+        /// @brief construct with parameters.
+        /// @param _cVec the records.
+        /// @param _cMask the mask.
+        coords_less(
+            const _VecTy& _cVec,
+            const size_t& _cMask)
+            : _Vec(_cVec)
+            , _Mask(_cMask)
+        {
+        }
+
+        /// @brief compare the records at
+        /// the supplied indices.
+        bool operator()(
+            const size_t& _Left,
+            const size_t& _Right) const
+        {
+            return conditional_compare_tuple<
+                1, std::tuple_size<
+                    tuple_type>::value>
+                ::compare(_Mask, _Vec[_Left],
+                    _Vec[_Right])<0;
+        }
+
+    private:
+
+        const _VecTy& 
+            _Vec;
+        size_t 
+            _Mask;
+    };
+
+    /// @brief build the ancestors of the
+    /// values of the fields declaring a
+    /// hierarchy, and insert them into the
+    /// metadata.
+    template <size_t I, size_t M>
+    struct ancestry_t
+    {
+        /// @brief build the ancestors of 
+        /// the Ith field and recurr.
+        /// @param _Defs the hierarchies.
+        /// @param _Meta the metadata.
+        /// @param _Anc destination tuple of
+        /// maps, leaf to ancestors.
+        template <
+            class _MetaTy,
+            class _AncTy>
+        static void build(
+            const hierarchy_list& _Defs,
+            _MetaTy& _Meta,
+            _AncTy& _Anc)
+        {
+            typedef typename 
+                std::tuple_element<I, 
+                    _MetaTy>::type
+                    ::value_type
+                value_type;
+
+            auto& _Set(std::get<I>(_Meta));
+            auto& _Map(std::get<I>(_Anc));
+
+            _Map.clear();
+
+            for (size_t h=0; h<_Defs.size();
+                ++h)
+            {
+                if (_Defs[h]._Field!=I)
+                    continue;
+
+                std::vector<std::string> _Strs;
+
+                for (auto It=_Set.cbegin(),
+                    E=_Set.cend(); It!=E; ++It)
+                {// the leaves
+                    if (*It==totcode<value_type>
+                        ::get())
+                        continue;
+
+                    _Defs[h].ancestors(
+                        code_string(*It), _Strs);
+
+                    for (size_t a=0; a<_Strs
+                        .size(); ++a)
+                    {
+                        value_type _Val;
+
+                        if (code_value(_Strs[a], 
+                            _Val) && _Val!=*It)
+                            _Map[*It].push_back(
+                                _Val);
+                    }
+                }
+
+                for (auto It=_Map.cbegin(),
+                    E=_Map.cend(); It!=E; ++It)
+                    _Set.insert(It->second
+                        .begin(), It->second
+                            .end());
+            }
+
+            ancestry_t<I+1, M>::build(
+                _Defs, _Meta, _Anc);
+        }
+
+        /// @brief add to a set of 
+        /// coordinates the ancestors, in
+        /// the Ith field, of each of them,
+        /// and recurr.
+        template <
+            class _AncTy,
+            class _SetTy>
+        static void expand(
+            const _AncTy& _Anc,
+            _SetTy& _Coords)
+        {
+            const auto& _Map(
+                std::get<I>(_Anc));
+
+            std::vector<typename 
+                _SetTy::value_type> _Add;
+
+            for (auto It=_Coords.cbegin(),
+                E=_Coords.cend(); !_Map.empty() 
+                    && It!=E; ++It)
+            {
+                auto F(_Map.find(
+                    std::get<I>(*It)));
+
+                if (F==_Map.end())
+                    continue;
+
+                for (size_t a=0; a<F->second
+                    .size(); ++a)
+                {
+                    _Add.push_back(*It);
+
+                    std::get<I>(_Add.back())=
+                        F->second[a];
+                }
+            }
+
+            _Coords.insert(_Add.begin(),
+                _Add.end());
+
+            ancestry_t<I+1, M>::expand(
+                _Anc, _Coords);
+        }
+    };
+
+    /// @brief ancestry_t stop recursion
+    template <size_t I>
+    struct ancestry_t <I, I>
+    {
+        /// @brief ancestry_t stop
+        template <
+            class _MetaTy,
+            class _AncTy>
+        static void build(
+            const hierarchy_list&,
+            _MetaTy&,
+            _AncTy&)
+        {
+        }
+
+        /// @brief ancestry_t stop
+        template <
+            class _AncTy,
+            class _SetTy>
+        static void expand(
+            const _AncTy&,
+            _SetTy&)
+        {
+        }
+    };
+
     /// @brief pure virtual class
     /// to handle typed microdata
     /// objects. See template struct
@@ -32,6 +325,54 @@ namespace confly
         /// @brief set mask 
         virtual void set_mask(
             const size_t& _cMask) =0;
+
+        /// @brief set the tables
+        /// to write
+        virtual void set_tables(
+            const table_list& 
+                _cTables) =0;
+
+        /// @brief dictionary encode
+        /// the records after read
+        virtual bool encode() =0;
+
+        /// @brief get the cardinalities
+        /// of the encoded fields
+        virtual auto shape() const
+            ->std::string =0;
+
+        /// @brief key the records by
+        /// their ordinal (before read)
+        virtual void set_keyed(
+            const size_t& _cSeed,
+            const size_t& _cBase) =0;
+
+        /// @brief insert the coordinates
+        /// of a saved state into the 
+        /// metadata
+        virtual bool read_meta(
+            std::istream& _S,
+            char _Sep) =0;
+
+        /// @brief collect the cells with
+        /// support in the records (after
+        /// read)
+        virtual void build_support() =0;
+
+        /// @brief sort the records by
+        /// their cells (after read)
+        virtual void sort() =0;
+
+        /// @brief set the hierarchies
+        /// of the fields (after read)
+        virtual void set_hierarchies(
+            const hierarchy_list& 
+                _cDefs) =0;
+
+        /// @brief get the number of 
+        /// records
+        virtual auto size() const
+            ->size_t =0;
 	};
 
     /// @brief arbitrary types
@@ -68,6 +409,22 @@ namespace confly
             tuple_type>
             container;
 
+        /// @brief the type of the 
+        /// ancestors of the values of each
+        /// field, empty unless the field
+        /// declares a hierarchy.
+        typedef std::tuple<
+            std::map<_Types, 
+                std::vector<_Types>>...>
+            ancestry;
+
+        /// @brief the type of the set of
+        /// the coordinates of the cells
+        /// with support, record ID zeroed.
+        typedef std::set<
+            tuple_type>
+            support_type;
+
         /// @brief type of the uniform
         /// integer distribution.
         typedef uniform_distribution<
@@ -81,7 +438,21 @@ namespace confly
             : _DB()
             , _Meta()
             , _Mask(0)
+            , _Lattice()
+            , _Tables()
+            , _TLattices()
+            , _Layout()
+            , _Codes()
             , _Unif(0, _DRE.max())
+            , _BKeyed(false)
+            , _Seed(0)
+            , _Base(0)
+            , _Support()
+            , _BSparse(false)
+            , _Order()
+            , _Starts()
+            , _Hierarchies()
+            , _Ancestry()
         {
             debug_msg<BDEBUGLEVEL3>
                 (__func__, M_CONSTRUCT);
@@ -142,10 +513,384 @@ namespace confly
 		}
 
         /// @brief set the mask.
+        /// @note reset the lattice to
+        /// all the marginals compatible
+        /// with the mask.
         virtual void set_mask(
             const size_t& _cMask)
         {
             _Mask=_cMask;
+
+            lattice::container _Cases;
+
+            lattice::full(
+                tuple_size::value-1,
+                _Mask, _Cases);
+
+            table_def _Def;
+            _Def._Cases=_Cases;
+
+            set_tables(table_list(
+                1, _Def));
+        }
+
+        /// @brief set the tables to 
+        /// write.
+        /// @param _cTables the tables,
+        /// whose cases (see struct
+        /// lattice) are compatible with
+        /// the mask.
+        /// @note the lattice of the
+        /// hypercubes is the union of
+        /// the tables' lattices.
+        virtual void set_tables(
+            const table_list& 
+                _cTables)
+        {
+            std::set<lattice::case_type>
+                _Union;
+
+            _Tables=_cTables;
+
+            _TLattices.clear();
+
+            for (size_t t=0; t<_Tables.size();
+                ++t)
+            {
+                const lattice::container& 
+                    _Cases(_Tables[t]._Cases);
+
+                _TLattices.push_back(lattice(
+                    tuple_size::value-1, 
+                    _Cases));
+
+                _Union.insert(_Cases.begin(),
+                    _Cases.end());
+            }
+
+            _Lattice=lattice(
+                tuple_size::value-1, 
+                lattice::container(
+                    _Union.begin(), 
+                    _Union.end()));
+        }
+
+        /// @brief dictionary encode the
+        /// fields of the records, as needed
+        /// by the flat hypercubes (see
+        /// struct cell_layout).
+        /// @return false if the number of
+        /// cells of the hypercube overflows.
+        /// @note call after read().
+        virtual bool encode()
+        {
+            const size_t _Width(
+                tuple_size::value-1);
+
+            std::vector<size_t> 
+                _Cards(_Width);
+            std::vector<cell_code_type> 
+                _Totals(_Width);
+
+            _Codes.reset(_Width);
+
+            encode_t<1, tuple_size::value>
+                ::encode(_Meta, _DB, _Mask,
+                    _Cards, _Totals, _Codes);
+
+            // record contributions column
+            std::vector<record_contrib>&
+                _Contribs(_Codes.contribs());
+
+            _Contribs.resize(_DB.size());
+
+            for (size_t i=0; i<_DB.size(); 
+                ++i)
+                _Contribs[i]=make_contrib(
+                    _DB[i]);
+
+            return _Layout.assign(
+                _Cards, _Totals);
+        }
+
+        /// @brief key the records by their
+        /// ordinal, so that record keys and
+        /// sampling (see mark()) do not 
+        /// depend on the sequence of the 
+        /// draws: appending records to the
+        /// microdata leaves the previous 
+        /// records' keys and samples 
+        /// unchanged.
+        /// @param _cSeed the seed.
+        /// @param _cBase ordinal of the
+        /// first record read, i.e. the
+        /// number of records aggregated
+        /// by the previous runs.
+        /// @note call before read().
+        virtual void set_keyed(
+            const size_t& _cSeed,
+            const size_t& _cBase)
+        {
+            _BKeyed=true;
+            _Seed=_cSeed;
+            _Base=_cBase;
+        }
+
+        /// @brief insert the coordinates
+        /// of the cells of a saved state
+        /// into the metadata, so that the
+        /// cells of the previous runs are
+        /// written as well.
+        /// @param _S the input stream, one
+        /// cell per line, the coordinates
+        /// first.
+        /// @param _Sep the separator.
+        virtual bool read_meta(
+            std::istream& _S,
+            char _Sep)
+        {
+            while (_S.good())
+            {
+                std::string _Ln;
+
+                std::getline(_S, _Ln);
+
+                if (_Ln.empty())
+                    continue;
+
+                std::istringstream _ISS(_Ln);
+
+                tuple_type _Tup;
+
+                read_tuple<tuple_type,
+                    1, tuple_size::value>(
+                        _ISS, _Sep, _Tup);
+
+                if (_ISS.fail())
+                    return false;
+
+                copy_insert_tuple<1, // skip id
+                    tuple_size::value>
+                        ::insert(_Tup, _Meta);
+
+                // the cells of the previous
+                // runs have support as well
+                if (_BSparse)
+                    _Support.insert(_Tup);
+            }
+
+            return true;
+        }
+
+        /// @brief collect the coordinates
+        /// of the cells with support in the
+        /// records, i.e. the cells updated
+        /// when all the records are sampled,
+        /// one for each marginal of the
+        /// lattice. The other cells of the
+        /// hypercubes are structural zeros,
+        /// not written (see hypercube::
+        /// write()).
+        /// @note call after read() and
+        /// set_tables(), before read_meta().
+        virtual void build_support()
+        {
+            const lattice::container& 
+                _Cases(_Lattice.cases());
+
+            _Support.clear();
+
+            for (size_t i=0; i<_DB.size();
+                ++i)
+            {
+                for (size_t c=0; c<_Cases
+                    .size(); ++c)
+                {
+                    tuple_type _Tup(_DB[i]);
+
+                    std::get<0>(_Tup)=0;
+
+                    conditional_set_tuple<
+                        totcode, 1, 
+                        tuple_size::value>
+                            ::set(_Cases[c], _Tup);
+
+                    _Support.insert(_Tup);
+                }
+            }
+
+            // the ancestors' cells
+            ancestry_t<1, tuple_size::value>
+                ::expand(_Ancestry, _Support);
+
+            _BSparse=true;
+        }
+
+        /// @brief test whether only the
+        /// cells with support are written
+        /// (see build_support()).
+        bool is_sparse() const
+        {
+            return _BSparse;
+        }
+
+        /// @brief sort the records by the
+        /// coordinates of their finest cell,
+        /// so that the sampled records of
+        /// each cube hit the cells in runs
+        /// (see get_starts()). The records
+        /// keep their record keys and, when
+        /// keyed, their ordinals (see mark()).
+        /// @note stable, call once after
+        /// read(), before encode() and
+        /// build_support().
+        virtual void sort()
+        {
+            const size_t _Sz(_DB.size());
+
+            std::vector<size_t> _Idx(_Sz);
+
+            for (size_t i=0; i<_Sz; ++i)
+                _Idx[i]=i;
+
+            std::stable_sort(_Idx.begin(),
+                _Idx.end(), coords_less<
+                    container>(_DB, _Mask));
+
+            container _Sorted;
+
+            _Sorted.reserve(_Sz);
+
+            _Starts.assign(_Sz, false);
+
+            for (size_t i=0; i<_Sz; ++i)
+            {
+                _Sorted.push_back(
+                    _DB[_Idx[i]]);
+
+                // first record of its cell
+                _Starts[i]= 0==i ||
+                    0!=conditional_compare_tuple<
+                    1, tuple_size::value>
+                    ::compare(_Mask, 
+                        _Sorted[i-1], 
+                            _Sorted[i]);
+            }
+
+            _DB.swap(_Sorted);
+            _Order.swap(_Idx);
+        }
+
+        /// @brief set the hierarchies of
+        /// the fields: the ancestors of the
+        /// values read are added to the
+        /// metadata, so that their cells are
+        /// written as well (see hypercube::
+        /// roll_up()).
+        /// @param _cDefs the hierarchies.
+        /// @note call once after read(),
+        /// before build_support().
+        virtual void set_hierarchies(
+            const hierarchy_list& _cDefs)
+        {
+            _Hierarchies=_cDefs;
+
+            ancestry_t<1, tuple_size::value>
+                ::build(_Hierarchies, _Meta,
+                    _Ancestry);
+        }
+
+        /// @brief test whether any field
+        /// has ancestors (see 
+        /// set_hierarchies()).
+        bool has_hierarchies() const
+        {
+            return ! _Hierarchies.empty();
+        }
+
+        /// @brief get the ancestors of the
+        /// values of each field.
+        auto get_ancestry() const
+            ->const ancestry&
+        {
+            return _Ancestry;
+        }
+
+        /// @brief get the flags of the
+        /// records starting a run of records
+        /// in the same finest cell, one for
+        /// each record.
+        /// @return const reference to the
+        /// flags, empty unless sorted (see 
+        /// sort()).
+        auto get_starts() const
+            ->const std::vector<bool>&
+        {
+            return _Starts;
+        }
+
+        /// @brief get the number of 
+        /// records
+        virtual auto size() const
+            ->size_t
+        {
+            return _DB.size();
+        }
+
+        /// @brief test whether the records
+        /// are keyed (see set_keyed()).
+        bool is_keyed() const
+        {
+            return _BKeyed;
+        }
+
+        /// @brief flag the records sampled
+        /// by a cube, with a Bernoulli 
+        /// draw keyed by the cube and the
+        /// ordinal of each record, i.e. its
+        /// position in the input.
+        /// @param _Cube the cube ordinal.
+        /// @param _Rate the sampling rate.
+        /// @param _Marks sampled flags, 
+        /// one for each record.
+        void mark(
+            const size_t& _Cube,
+            const double& _Rate,
+            std::vector<bool>& _Marks)
+            const
+        {
+            _Marks.assign(_DB.size(), false);
+
+            for (size_t i=0; i<_DB.size();
+                ++i)
+            {
+                _Marks[i]=keyed_unit(_Seed,
+                    _Cube, _Base+(_Order.empty() ?
+                        i : _Order[i]))<_Rate;
+            }
+        }
+
+        /// @brief get the cardinalities of
+        /// the fields, as a comma separated
+        /// list.
+        /// @return the list, empty if the
+        /// records are not encoded.
+        /// @note used to generate the shape
+        /// specialized plugins.
+        virtual auto shape() const
+            ->std::string
+        {
+            std::ostringstream _OSS;
+
+            for (size_t f=0; 0<_Layout.size()
+                && f<_Layout.width(); ++f)
+            {
+                if (f) _OSS << CHARCM;
+
+                _OSS << _Layout.card(f);
+            }
+
+            return _OSS.str();
         }
 
         /// @brief get const reference
@@ -166,6 +911,16 @@ namespace confly
             return _Meta;
         }
 
+        /// @brief get const reference
+        /// to the coordinates of the cells
+        /// with support (see 
+        /// build_support()).
+        auto get_support() const 
+            ->const support_type&
+        {
+            return _Support;
+        }
+
         /// @brief get mask
         auto get_mask() const 
             ->const size_t&
@@ -173,6 +928,46 @@ namespace confly
             return _Mask;
         }
 
+        /// @brief get the lattice of 
+        /// marginals.
+        auto get_lattice() const 
+            ->const lattice&
+        {
+            return _Lattice;
+        }
+
+        /// @brief get the tables.
+        auto get_tables() const 
+            ->const table_list&
+        {
+            return _Tables;
+        }
+
+        /// @brief get the lattice of 
+        /// marginals of each table.
+        auto get_table_lattices() const 
+            ->const std::vector<lattice>&
+        {
+            return _TLattices;
+        }
+
+        /// @brief get the layout of
+        /// the flat hypercubes.
+        auto get_layout() const 
+            ->const cell_layout&
+        {
+            return _Layout;
+        }
+
+        /// @brief get the packed
+        /// dictionary codes and the keys
+        /// of the records.
+        auto get_codes() const 
+            ->const packed_columns&
+        {
+            return _Codes;
+        }
+
 	private:
 
 		void insert(
@@ -193,9 +988,20 @@ namespace confly
             {
                 //unif<long> _Unif;
 
-                // set record key
-                std::get<0>(_Tup)=
+                // set record key, keyed
+                // by the ordinal if 
+                // requested (the stream
+                // differs from any cube's)
+                std::get<0>(_Tup)= _BKeyed ?
+                    keyed_draw(_Seed, ~0ULL,
+                        _Base+_DB.size())
+                        %((uint64_t)_DRE
+                            .max()+1) :
                     _Unif(_DRE);
+#ifdef FIXED_RKEY
+                // 32 bits (see cell_key())
+                std::get<0>(_Tup)&=0xffffffffL;
+#endif
 
                 // install record
 				_DB.push_back(_Tup);
@@ -221,7 +1027,35 @@ namespace confly
             _Meta;
         size_t 
             _Mask;
+        lattice
+            _Lattice;
+        table_list
+            _Tables;
+        std::vector<lattice>
+            _TLattices;
+        cell_layout
+            _Layout;
+        packed_columns
+            _Codes;
         unif_type
             _Unif;
+        bool
+            _BKeyed;
+        size_t
+            _Seed;
+        size_t
+            _Base;
+        support_type
+            _Support;
+        bool
+            _BSparse;
+        std::vector<size_t>
+            _Order;
+        std::vector<bool>
+            _Starts;
+        hierarchy_list
+            _Hierarchies;
+        ancestry
+            _Ancestry;
 	};
 }
\ No newline at end of file
@@ -14,6 +14,14 @@
 
 namespace confly
 {
+    /// @brief type of the additional
+    /// preprocessor definitions written
+    /// to rttg_types.hpp when generating
+    /// a plugin (name, value).
+    typedef std::map<
+        std::string, std::string>
+        plugin_defines;
+
     // -------------------------------------
     // plugin mangled symbols
 
@@ -34,6 +42,21 @@ namespace confly
         "_ZN6confly11import_"
         "sizeERKm";
 
+    static const char*
+        sym_import_threads=
+        "_ZN6confly14import_"
+        "threadsERKm";
+
+    static const char*
+        sym_import_radix=
+        "_ZN6confly12import_"
+        "radixERKb";
+
+    static const char*
+        sym_import_mechanisms=
+        "_ZN6confly17import_"
+        "mechanismsERKm";
+
     static const char*
         sym_seed_prng=
         "_ZN6confly9seed_prn"
@@ -109,6 +132,24 @@ namespace confly
             func_import_size) (
                 const size_t&);
 
+		/// @brief type of function
+		/// import_threads
+        typedef void (*
+            func_import_threads) (
+                const size_t&);
+
+		/// @brief type of function
+		/// import_radix
+        typedef void (*
+            func_import_radix) (
+                const bool&);
+
+		/// @brief type of function
+		/// import_mechanisms
+        typedef void (*
+            func_import_mechanisms) (
+                const size_t&);
+
 		/// @brief type of function
 		/// seed_prng
         typedef void (*
@@ -151,22 +192,38 @@ namespace confly
 		/// flags fields that must be included
 		/// as is in the hypercubes, or rather
 		/// only their aggregation is needed.
+		/// @param _cTables the tables to write
+		/// and their marginals (see struct 
+		/// lattice).
+		/// @param _cDefines additional 
+		/// definitions the plugin is 
+		/// specialized on, empty for the
+		/// generic plugin.
 		plugin(
 			const std::string& 
                 _cPathProject,
 			const std::string& 
                 _cTypeCode,
             const size_t& 
-                _cMask)
+                _cMask,
+            const table_list&
+                _cTables,
+            const plugin_defines&
+                _cDefines)
 			: _PathProject(
                 _cPathProject)
 			, _SOName(so_name(
-				_cTypeCode))
+				plugin_code(_cTypeCode,
+					_cDefines)))
             , _Mask(_cMask)
+            , _Tables(_cTables)
 			, _Handle(0)
             , _FuncImportPtable(0)
             , _FuncImportNP(0)
             , _FuncImportSize(0)
+            , _FuncImportThreads(0)
+            , _FuncImportRadix(0)
+            , _FuncImportMech(0)
             , _FuncSeedPrng(0)
 			, _FuncMakeMicro(0)
 			, _FuncMakeCube(0)
@@ -211,6 +268,27 @@ namespace confly
 				return false;
 			}
 
+			else if(! get_procedure(
+				_FuncImportThreads,
+				sym_import_threads))
+			{
+				return false;
+			}
+
+			else if(! get_procedure(
+				_FuncImportRadix,
+				sym_import_radix))
+			{
+				return false;
+			}
+
+			else if(! get_procedure(
+				_FuncImportMech,
+				sym_import_mechanisms))
+			{
+				return false;
+			}
+
 			else if(! get_procedure(
 				_FuncSeedPrng,
 				sym_seed_prng))
@@ -321,6 +399,69 @@ namespace confly
 			_Cast(_Sz);
         }
 
+		/// @brief cast pointer to
+		/// plugin's import_threads
+		/// function.
+        void import_threads(
+            const size_t& _Threads)
+        {
+			if (! good())
+			{
+				fail(__func__);
+
+				return;
+			}
+
+			func_import_threads
+                _Cast=reinterpret_cast<
+					func_import_threads>(
+                        _FuncImportThreads);
+
+			_Cast(_Threads);
+        }
+
+		/// @brief cast pointer to
+		/// plugin's import_radix
+		/// function.
+        void import_radix(
+            const bool& _BRadix)
+        {
+			if (! good())
+			{
+				fail(__func__);
+
+				return;
+			}
+
+			func_import_radix
+                _Cast=reinterpret_cast<
+					func_import_radix>(
+                        _FuncImportRadix);
+
+			_Cast(_BRadix);
+        }
+
+		/// @brief cast pointer to
+		/// plugin's import_mechanisms
+		/// function.
+        void import_mechanisms(
+            const size_t& _Mech)
+        {
+			if (! good())
+			{
+				fail(__func__);
+
+				return;
+			}
+
+			func_import_mechanisms
+                _Cast=reinterpret_cast<
+					func_import_mechanisms>(
+                        _FuncImportMech);
+
+			_Cast(_Mech);
+        }
+
 		/// @brief cast pointer to
 		/// plugin's seed_prng
 		/// function.
@@ -357,6 +498,7 @@ namespace confly
             if (_Ptr)
             {
                 _Ptr->set_mask(_Mask);
+                _Ptr->set_tables(_Tables);
             }
             
             return _Ptr;
@@ -432,6 +574,11 @@ namespace confly
 		/// the template classes of the plugin.
 		/// @param _TypeCode identifying the
 		/// types used to read the microdata.
+		/// @param _Defines additional 
+		/// definitions written along with 
+		/// the types (e.g. SHAPE, see struct
+		/// fixed_shape); their hash is 
+		/// appended to the plugin's name.
 		/// @return true in case of success in
 		/// creating the plugin, or false
 		/// otherwise.
@@ -441,17 +588,20 @@ namespace confly
 			const std::string&
                 _Types,
 			const std::string&
-                _TypeCode)
+                _TypeCode,
+			const plugin_defines&
+                _Defines)
 		{
 			if (! create_rttg_types(
 				_PathProject,
-				_Types))
+				_Types,
+				_Defines))
 			{
 				return false;
 			}
 
-			if (! build(
-				_TypeCode))
+			if (! build(plugin_code(
+				_TypeCode, _Defines)))
 			{
 				return false;
 			}
@@ -493,6 +643,43 @@ namespace confly
 			return _OSS.str();
 		}
 
+		static auto plugin_code(
+			const std::string& _TypeCode,
+			const plugin_defines& _Defines)
+			->std::string
+		{// lllll, or lllll_<hash> if
+			// specialized (FNV-1a)
+			if (_Defines.empty())
+				return _TypeCode;
+
+			unsigned long long _Hash(
+				14695981039346656037ULL);
+
+			for (auto It=_Defines.cbegin(),
+				E=_Defines.cend(); It!=E;
+					++It)
+			{
+				const std::string _Ln(
+					It->first+CHARSP+
+					It->second+CHARNL);
+
+				for (size_t i=0; i<_Ln.size();
+					++i)
+				{
+					_Hash^=(unsigned char)_Ln[i];
+					_Hash*=1099511628211ULL;
+				}
+			}
+
+			std::ostringstream 
+				_OSS; _OSS 
+				<< _TypeCode << CHARUS
+				<< std::hex << std::setw(16)
+				<< std::setfill('0') << _Hash;
+
+			return _OSS.str();
+		}
+
 		static auto so_name(
 			const std::string& _Types)
 			->std::string
@@ -520,7 +707,9 @@ namespace confly
 			const std::string& 
                 _PathProject,
 			const std::string& 
-                _Types)
+                _Types,
+			const plugin_defines&
+                _Defines)
 		{
 			std::ostringstream 
 				_OSS; _OSS 
@@ -536,6 +725,17 @@ namespace confly
 			<< _Types
 			<< CHARNL;
 
+			for (auto It=_Defines.cbegin(),
+				E=_Defines.cend(); It!=E;
+					++It)
+			{
+				_Fout 
+				<< "#define "
+				<< It->first << CHARSP
+				<< It->second
+				<< CHARNL;
+			}
+
 			return _Fout.good();
 		}
 
@@ -644,6 +844,8 @@ namespace confly
 			_SOName;
         size_t
             _Mask;
+        table_list
+            _Tables;
 		handle_type
 			_Handle;
 		handle_type
@@ -653,6 +855,12 @@ namespace confly
 		handle_type
             _FuncImportSize;
 		handle_type
+            _FuncImportThreads;
+		handle_type
+            _FuncImportRadix;
+		handle_type
+            _FuncImportMech;
+		handle_type
             _FuncSeedPrng;
 		handle_type
 			_FuncMakeMicro;
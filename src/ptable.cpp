@@ -92,6 +92,11 @@ auto ptable_record_api upper() const
 
 ptable_api ptable() 
     : _NCat(0) 
+    , _PtableRecords()
+    , _Rows()
+    , _Lower()
+    , _Upper()
+    , _Values()
 {
 }
 
@@ -107,6 +112,9 @@ void ptable_api insert(
 
     if (_Rec._I>_NCat)
         _NCat=_Rec._I;
+
+    // unfreeze
+    _Rows.clear();
 }
 
 void ptable_api write(
@@ -160,6 +168,55 @@ auto ptable_api lookup(
     if (_IDX>_NCat)
         _IDX%=(_NCat+1);
 
+    if (_Rows.empty() || _IDX<0)
+        return lookup_scan(
+            _IDX, _Ckey);
+
+    const size_t 
+        _Beg(_Rows[_IDX]), 
+        _End(_Rows[_IDX+1]);
+
+    if (_Beg==_End)
+        return 0;
+
+    // first upper bound not less
+    // than the key, branchless
+    const real_type* 
+        _Base(&_Upper[_Beg]);
+    size_t 
+        _Len(_End-_Beg);
+
+    while (_Len>1)
+    {
+        const size_t 
+            _Half(_Len/2);
+
+        _Base+=(_Base[_Half-1]<_Ckey) 
+            ? _Half : 0;
+
+        _Len-=_Half;
+    }
+
+    const size_t _K(
+        _Base-&_Upper[0]);
+
+    // the rows are sorted and not
+    // overlapping: if the first
+    // record ending after the key
+    // starts after it, no record
+    // holds the key (as the scan)
+    if (_Upper[_K]>=_Ckey &&
+        _Lower[_K]<=_Ckey)
+        return _Values[_K];
+
+    return 0;
+}
+
+auto ptable_api lookup_scan(
+    const integer_type& _IDX, 
+    const real_type& _Ckey)
+    const ->integer_type
+{
     auto _PairII=
         _PtableRecords
         .equal_range(_IDX);
@@ -178,6 +235,67 @@ auto ptable_api lookup(
     return 0.0;
 }
 
+bool ptable_api freeze()
+{
+    _Rows.clear();
+    _Lower.clear();
+    _Upper.clear();
+    _Values.clear();
+
+    if (_NCat<0)
+        return false;
+
+    std::vector<size_t> _Tmp(
+        _NCat+2, 0);
+
+    _Lower.reserve(_PtableRecords.size());
+    _Upper.reserve(_PtableRecords.size());
+    _Values.reserve(_PtableRecords.size());
+
+    for (integer_type i=0; i<=_NCat; ++i)
+    {// rows in insertion order, as
+        // the multimap keeps the
+        // records of the same count
+        auto _PairII=
+            _PtableRecords
+            .equal_range(i);
+
+        _Tmp[i]=_Upper.size();
+
+        for (auto I=_PairII.first, 
+            E=_PairII.second;
+                I!=E; ++I)
+        {
+            const real_type
+                _Lb(I->second.lower()),
+                _Ub(I->second.upper());
+
+            if (_Lb>_Ub || (_Tmp[i]<
+                _Upper.size() && (
+                _Ub<_Upper.back() ||
+                _Lb<_Upper.back())))
+            {// unsorted or overlapping
+                _Lower.clear();
+                _Upper.clear();
+                _Values.clear();
+
+                return false;
+            }
+
+            _Lower.push_back(_Lb);
+            _Upper.push_back(_Ub);
+            _Values.push_back(
+                I->second.value());
+        }
+    }
+
+    _Tmp[_NCat+1]=_Upper.size();
+
+    _Rows.swap(_Tmp);
+
+    return true;
+}
+
 auto ptable_api get_ncat() 
     const 
     ->integer_type
@@ -191,6 +309,25 @@ void ptable_api set_ncat(
     _NCat=_Val;
 }
 
+auto ptable_api get_bound() 
+    const 
+    ->integer_type
+{
+    integer_type _D(0);
+
+    for (auto I=_PtableRecords
+        .cbegin(), E=_PtableRecords
+            .cend(); I!=E; ++I)
+    {
+        const integer_type _V(
+            I->second.value());
+
+        _D=std::max(_D, _V<0 ? -_V : _V);
+    }
+
+    return _D;
+}
+
 auto ptable_api size() const
     ->size_t
 {
@@ -226,6 +363,10 @@ bool confly_api load_ptable(
         return false;
     }
 
+    // contiguous rows, unless
+    // unsorted (scanned then)
+    _PTable.freeze();
+
     return true;
 }
 
@@ -258,3 +399,273 @@ bool confly_api create_ptable(
 
 
 
+// -----------------------------------------
+// native ptable generator
+
+namespace
+{
+    typedef std::vector<double>
+        real_vector;
+
+    // nondecreasing least squares
+    // fit of the values at _Idx, in
+    // their order (pool adjacent
+    // violators)
+    void increasing_fit(
+        const std::vector<size_t>& _Idx,
+        real_vector& _Y)
+    {
+        real_vector _Sum;
+        std::vector<size_t> _Len;
+
+        for (size_t k=0; k<_Idx.size(); ++k)
+        {
+            _Sum.push_back(_Y[_Idx[k]]);
+            _Len.push_back(1);
+
+            while (_Sum.size()>1 && 
+                _Sum[_Sum.size()-2]*_Len.back()>
+                _Sum.back()*_Len[_Len.size()-2])
+            {// pool the last two blocks
+                _Sum[_Sum.size()-2]+=_Sum.back();
+                _Len[_Len.size()-2]+=_Len.back();
+                _Sum.pop_back();
+                _Len.pop_back();
+            }
+        }
+
+        for (size_t b=0, k=0; b<_Sum.size(); ++b)
+        {
+            for (size_t n=0; n<_Len[b]; ++n, ++k)
+                _Y[_Idx[k]]=_Sum[b]/_Len[b];
+        }
+    }
+
+    // the maximum entropy distribution
+    // of the noise _V (increasing) with
+    // exponents _A*v+_B*v^2, fitted to
+    // probabilities not increasing away
+    // from v=0: as the exponents are
+    // concave, the values next to 0 are
+    // pooled on one side at most.
+    void entropy_fit(
+        const real_vector& _V,
+        const double& _A,
+        const double& _B,
+        real_vector& _P)
+    {
+        const size_t _N(_V.size());
+
+        real_vector _L(_N), _R(_N);
+
+        std::vector<size_t> 
+            _Left, _Right;
+
+        for (size_t k=0; k<_N; ++k)
+        {
+            _L[k]=_R[k]=_A*_V[k]+_B*_V[k]*_V[k];
+
+            if (_V[k]<=0) 
+                _Left.push_back(k);
+        }
+
+        for (size_t k=_N; k>0; --k)
+        {
+            if (_V[k-1]>=0)
+                _Right.push_back(k-1);
+        }
+
+        increasing_fit(_Left, _L);
+        increasing_fit(_Right, _R);
+
+        double _Max(-HUGE_VAL);
+
+        for (size_t k=0; k<_N; ++k)
+        {
+            _P[k]=_V[k]<0 ? _L[k] : _V[k]>0 ? 
+                _R[k] : std::max(_L[k], _R[k]);
+
+            _Max=std::max(_Max, _P[k]);
+        }
+
+        double _Sum(0);
+
+        for (size_t k=0; k<_N; ++k)
+            _Sum+=(_P[k]=std::exp(_P[k]-_Max));
+
+        for (size_t k=0; k<_N; ++k)
+            _P[k]/=_Sum;
+    }
+
+    // the moment of order _Ord
+    auto moment(
+        const real_vector& _V,
+        const real_vector& _P,
+        const int& _Ord)
+        ->double
+    {
+        double _M(0);
+
+        for (size_t k=0; k<_V.size(); ++k)
+            _M+=_P[k]*(1==_Ord ? 
+                _V[k] : _V[k]*_V[k]);
+
+        return _M;
+    }
+
+    // the fit with mean 0, bisecting
+    // the linear coefficient (the mean
+    // grows with it)
+    void zero_mean_fit(
+        const real_vector& _V,
+        const double& _B,
+        real_vector& _P)
+    {
+        double _Hi(1);
+
+        for (; _Hi<1e9; _Hi*=2)
+        {
+            entropy_fit(_V, -_Hi, _B, _P);
+            const double _Lo(moment(_V, _P, 1));
+
+            entropy_fit(_V, _Hi, _B, _P);
+
+            if (_Lo<0 && moment(_V, _P, 1)>0)
+                break;
+        }
+
+        double _Lo(-_Hi);
+
+        for (int n=0; n<200; ++n)
+        {
+            const double _Mid((_Lo+_Hi)/2);
+
+            if (_Mid<=_Lo || _Mid>=_Hi)
+                break;
+
+            entropy_fit(_V, _Mid, _B, _P);
+
+            (moment(_V, _P, 1)<0 ? 
+                _Lo : _Hi)=_Mid;
+        }
+
+        entropy_fit(_V, (_Lo+_Hi)/2, 
+            _B, _P);
+    }
+
+    // the noise of a count: maximum 
+    // entropy with mean 0 and variance
+    // at most _Var (the variance shrinks
+    // with the quadratic coefficient)
+    bool noise_fit(
+        const real_vector& _V,
+        const double& _Var,
+        real_vector& _P)
+    {
+        if (_V.front()>=0 || _V.back()<=0)
+        {// mean 0: no noise
+            for (size_t k=0; k<_V.size(); ++k)
+                _P[k]=0==_V[k] ? 1 : 0;
+
+            return true;
+        }
+
+        zero_mean_fit(_V, 0, _P);
+
+        if (moment(_V, _P, 2)<=_Var)
+            return true;
+
+        double _Lo(-1), _Hi(0);
+
+        for (;; _Lo*=2)
+        {
+            if (_Lo<-1e12)
+                return false;
+
+            zero_mean_fit(_V, _Lo, _P);
+
+            if (moment(_V, _P, 2)<=_Var)
+                break;
+        }
+
+        for (int n=0; n<200; ++n)
+        {
+            const double _Mid((_Lo+_Hi)/2);
+
+            if (_Mid<=_Lo || _Mid>=_Hi)
+                break;
+
+            zero_mean_fit(_V, _Mid, _P);
+
+            (moment(_V, _P, 2)<=_Var ? 
+                _Lo : _Hi)=_Mid;
+        }
+
+        zero_mean_fit(_V, _Lo, _P);
+
+        return true;
+    }
+}
+
+bool confly_api generate_ptable(
+    ptable& _PTable,
+    const real_type& D_CK, 
+    const real_type& V_CK, 
+    const real_type& js_CK)
+{
+    const integer_type 
+        _D(D_CK), _Js(js_CK),
+        _NCat(_D+_Js+1);
+
+    for (integer_type i=0; i<=_NCat; ++i)
+    {
+        real_vector _V, _P;
+
+        for (integer_type v=-_D; v<=_D; ++v)
+        {// the noisy counts are 0 or
+            // beyond the threshold
+            const integer_type _J(i+v);
+
+            if (0==_J || _J>_Js)
+                _V.push_back(v);
+        }
+
+        _P.resize(_V.size());
+
+        if (! noise_fit(_V, V_CK, _P))
+        {
+            flush_msg(std::cout,
+                M_ERROR,
+                M_PTABLE,
+                M_VARIANCE,
+                V_CK);
+
+            return false;
+        }
+
+        // the bounds of the cell keys,
+        // rounded to 8 decimals, the 
+        // probabilities their differences
+        double _Cum(0), _Lb(0);
+
+        for (size_t k=0; k<_V.size(); ++k)
+        {
+            _Cum+=_P[k];
+
+            const double _Ub(k+1==_V.size() ?
+                1.0 : std::floor(_Cum*1e8+0.5)/1e8);
+
+            if (_Ub>_Lb)
+            _PTable.insert(ptable_record(i, 
+                i+(integer_type)_V[k], _Ub-_Lb,
+                    (integer_type)_V[k], _Lb, _Ub));
+
+            _Lb=_Ub;
+        }
+    }
+
+    _PTable.set_ncat(_NCat);
+
+    return _PTable.freeze();
+}
+
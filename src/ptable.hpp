@@ -136,11 +136,27 @@ namespace confly
 			std::istream& _S);
 		
 		/// @brief lookup ptable
+		/// @note searches the frozen
+		/// rows if any (see freeze()),
+		/// scans the records otherwise.
 		auto lookup(
             const integer_type& _I, 
 			const real_type& _Ckey)
 			const ->integer_type;
 
+		/// @brief freeze the records into
+		/// contiguous rows (one for each
+		/// count), looked up by branchless
+		/// binary search on the upper 
+		/// bounds of the cell keys.
+		/// @return false, leaving the table
+		/// unfrozen, if a row has unsorted
+		/// or overlapping bounds (the search
+		/// would not match the scan).
+		/// @note called by load_ptable();
+		/// inserting a record unfreezes.
+		bool freeze();
+
 		/// @brief get number of 
 		/// categories
         auto get_ncat() const 
@@ -151,17 +167,38 @@ namespace confly
         void set_ncat(
             const integer_type&);
 
+		/// @brief get the largest
+		/// absolute noise value (i.e.
+		/// the CK parameter D)
+        auto get_bound() const 
+            ->integer_type;
+
 		/// @brief get size of
 		/// container
 		auto size() const
 			->size_t;
 
     private:			
+
+		auto lookup_scan(
+            const integer_type& _IDX, 
+			const real_type& _Ckey)
+			const ->integer_type;
 			
 		integer_type 
 			_NCat;
 		container
 			_PtableRecords;
+		// frozen rows: records of the
+		// count i at [_Rows[i], _Rows[i+1])
+		std::vector<size_t>
+			_Rows;
+		std::vector<real_type>
+			_Lower;
+		std::vector<real_type>
+			_Upper;
+		std::vector<integer_type>
+			_Values;
 	};
 
 	// --------------------------------------------
@@ -183,6 +220,31 @@ namespace confly
 		const real_type& D_CK, 
 		const real_type& V_CK, 
 		const real_type& js_CK);
+
+	/// @brief generate the ptable of the
+	/// Cell-Key count noise natively, as
+	/// the "ptable" R package does with
+	/// its default options.
+	/// @param _PTable destination ptable.
+	/// @param D_CK bound of the noise.
+	/// @param V_CK variance of the noise.
+	/// @param js_CK small-count threshold.
+	/// @return false if the noise of a 
+	/// count cannot have variance V_CK.
+	/// @note the noise of each count i, 
+	/// from 0 to D+js+1, takes the values
+	/// v in [-D,D] such that i+v is 0 or 
+	/// greater than js: its distribution
+	/// has the maximum entropy with mean 0,
+	/// variance at most V_CK and the
+	/// probabilities not increasing away
+	/// from v=0. The cumulative ones are
+	/// rounded to 8 decimals.
+	bool generate_ptable(
+		ptable& _PTable,
+		const real_type& D_CK, 
+		const real_type& V_CK, 
+		const real_type& js_CK);
 }
 
 
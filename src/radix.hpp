@@ -0,0 +1,925 @@
+#pragma once
+#include <unistd.h>
+#include <stdint.h>
+#include <limits>
+#include <vector>
+
+#include "lattice.hpp"
+#include "response.hpp"
+
+namespace confly
+{
+    /// @brief type of the dictionary code
+    /// of a field value.
+    typedef uint32_t
+        cell_code_type;
+
+    /// @brief dictionary codes of the
+    /// microdata records, one bit-packed
+    /// column for each field (record ID
+    /// excluded), plus the column of the
+    /// record contributions (record keys
+    /// and magnitudes).
+    /// @note each column uses the bits
+    /// needed by the cardinality of its 
+    /// field, packed in 64 bits words
+    /// without straddling the words, so
+    /// that a field with 2 values takes
+    /// 1 bit per record.
+    struct packed_columns
+    {
+        /// @brief type of a packed word
+        typedef uint64_t
+            word_type;
+
+        /// @brief construct empty.
+        packed_columns()
+            : _Cols()
+            , _Contribs()
+        {
+        }
+
+        /// @brief set the number of
+        /// columns, and clear them.
+        void reset(
+            const size_t& _Width)
+        {
+            _Cols.assign(_Width, 
+                column());
+
+            _Contribs.clear();
+        }
+
+        /// @brief pack the codes of a 
+        /// field.
+        /// @param _F position of the field
+        /// (0 for the first one after the
+        /// record ID).
+        /// @param _Card cardinality of the
+        /// field.
+        /// @param _Codes the codes, one for
+        /// each record.
+        void assign(
+            const size_t& _F,
+            const size_t& _Card,
+            const std::vector<cell_code_type>&
+                _Codes)
+        {
+            column& _C(_Cols[_F]);
+
+            _C._Bits=1; while (_C._Bits<32 
+                && ((size_t)1<<_C._Bits)<_Card)
+                ++_C._Bits;
+
+            _C._PerWord=64/_C._Bits;
+            _C._Mask=((word_type)1
+                <<_C._Bits)-1;
+
+            _C._Words.assign((_Codes.size()
+                +_C._PerWord-1)/_C._PerWord, 0);
+
+            for (size_t i=0; i<_Codes.size(); 
+                ++i)
+            {
+                _C._Words[i/_C._PerWord]|=
+                    (word_type)_Codes[i]<<
+                    (i%_C._PerWord*_C._Bits);
+            }
+        }
+
+        /// @brief get the column of the
+        /// record contributions.
+        auto contribs()
+            ->std::vector<record_contrib>&
+        {
+            return _Contribs;
+        }
+
+        /// @brief get the contribution of
+        /// record _I.
+        auto contrib(
+            const size_t& _I) const
+            ->const record_contrib&
+        {
+            return _Contribs[_I];
+        }
+
+        /// @brief get the code of the field
+        /// _F of record _I.
+        auto get(
+            const size_t& _F,
+            const size_t& _I) const
+            ->cell_code_type
+        {
+            const column& _C(_Cols[_F]);
+
+            return (_C._Words[_I/_C._PerWord]
+                >>(_I%_C._PerWord*_C._Bits))
+                    &_C._Mask;
+        }
+
+        /// @brief unpack the codes of the
+        /// field _F of _N records starting
+        /// from record _Beg, scaled by the
+        /// stride of the field, i.e. their
+        /// contribution to the cell offsets.
+        /// @param _Out destination buffer
+        /// of _N offsets.
+        void unpack(
+            const size_t& _F,
+            const size_t& _Beg,
+            const size_t& _N,
+            const size_t& _Stride,
+            size_t* _Out)
+            const
+        {
+            const column& _C(_Cols[_F]);
+
+            size_t 
+                w(_Beg/_C._PerWord),
+                s(_Beg%_C._PerWord),
+                j(0);
+
+            while (j<_N)
+            {// word by word, the inner
+                // loop vectorizes
+                const word_type _W(
+                    _C._Words[w]>>
+                        (s*_C._Bits));
+
+                const size_t n(std::min(
+                    _C._PerWord-s, _N-j));
+
+                for (size_t t=0; t<n; ++t)
+                    _Out[j+t]=((_W>>(t*
+                        _C._Bits))&_C._Mask)
+                            *_Stride;
+
+                j+=n; ++w; s=0;
+            }
+        }
+
+        /// @brief get the number of 
+        /// columns.
+        auto width() const
+            ->size_t
+        {
+            return _Cols.size();
+        }
+
+    private:
+
+        struct column
+        {
+            column()
+                : _Bits(1)
+                , _PerWord(64)
+                , _Mask(1)
+                , _Words()
+            {
+            }
+
+            size_t
+                _Bits;
+            size_t
+                _PerWord;
+            word_type
+                _Mask;
+            std::vector<word_type>
+                _Words;
+        };
+
+        std::vector<column>
+            _Cols;
+        std::vector<record_contrib>
+            _Contribs;
+    };
+
+    /// @brief dense layout of a hypercube
+    /// stored as a flat array of cells.
+    /// @note each field (record ID
+    /// excluded) is dictionary encoded
+    /// with the position of its value in
+    /// the ordered metadata set, total
+    /// code included. The cells are laid
+    /// out in row-major order, the first
+    /// field varying slowest, so that
+    /// iterating the metadata visits the
+    /// cells at increasing offsets.
+    struct cell_layout
+    {
+        /// @brief construct empty.
+        cell_layout()
+            : _Cards()
+            , _Totals()
+            , _Strides()
+            , _Size(0)
+        {
+        }
+
+        /// @brief compute the strides of the
+        /// fields and the number of cells.
+        /// @param _cCards the cardinality of
+        /// each field, total code included.
+        /// @param _cTotals the code of the
+        /// total of each field.
+        /// @return false if the number of
+        /// cells overflows, true otherwise.
+        bool assign(
+            const std::vector<size_t>& _cCards,
+            const std::vector<cell_code_type>&
+                _cTotals)
+        {
+            _Cards=_cCards;
+            _Totals=_cTotals;
+            _Strides.assign(
+                _Cards.size(), 1);
+            _Size=1;
+
+            for (size_t f=_Cards.size();
+                f-- >0;)
+            {// last field varies fastest
+                _Strides[f]=_Size;
+
+                if (_Cards[f] && _Size>
+                    std::numeric_limits<
+                        size_t>::max()
+                            /_Cards[f])
+                {
+                    _Size=0;
+
+                    return false;
+                }
+
+                _Size*=_Cards[f];
+            }
+
+            return true;
+        }
+
+        /// @brief get the number of fields.
+        auto width() const
+            ->size_t
+        {
+            return _Cards.size();
+        }
+
+        /// @brief get the number of cells.
+        auto size() const
+            ->const size_t&
+        {
+            return _Size;
+        }
+
+        /// @brief get the cardinality of
+        /// the field at position _F (0 for
+        /// the first field after the record
+        /// ID).
+        auto card(
+            const size_t& _F) const
+            ->const size_t&
+        {
+            return _Cards[_F];
+        }
+
+        /// @brief get the stride of the
+        /// field at position _F (0 for the
+        /// first field after the record ID).
+        auto stride(
+            const size_t& _F) const
+            ->const size_t&
+        {
+            return _Strides[_F];
+        }
+
+        /// @brief get the code of the
+        /// total of the field at position
+        /// _F.
+        auto total(
+            const size_t& _F) const
+            ->const cell_code_type&
+        {
+            return _Totals[_F];
+        }
+
+    private:
+
+        std::vector<size_t>
+            _Cards;
+        std::vector<cell_code_type>
+            _Totals;
+        std::vector<size_t>
+            _Strides;
+        size_t
+            _Size;
+    };
+
+    /// @brief product of compile-time
+    /// cardinalities.
+    template <size_t... _Cards>
+    struct shape_product;
+
+    /// @brief shape_product stop
+    template <>
+    struct shape_product <>
+    {
+        static const size_t 
+            value=1;
+    };
+
+    /// @brief shape_product recursion
+    template <size_t _Card, 
+        size_t... _Other>
+    struct shape_product <
+        _Card, _Other...>
+    {
+        static const size_t 
+            value=_Card*shape_product<
+                _Other...>::value;
+    };
+
+    /// @brief stride of the field at
+    /// position _F given the compile-time
+    /// cardinalities, i.e. the product of
+    /// the cardinalities of the fields
+    /// after it.
+    template <size_t _F, size_t... _Cards>
+    struct shape_stride;
+
+    /// @brief shape_stride recursion
+    template <size_t _F, size_t _Card, 
+        size_t... _Other>
+    struct shape_stride <
+        _F, _Card, _Other...>
+    {
+        static const size_t
+            value=shape_stride<_F-1,
+                _Other...>::value;
+    };
+
+    /// @brief shape_stride stop
+    template <size_t _Card, 
+        size_t... _Other>
+    struct shape_stride <
+        0, _Card, _Other...>
+    {
+        static const size_t
+            value=shape_product<
+                _Other...>::value;
+    };
+
+    /// @brief list of field positions.
+    template <size_t... _Idx>
+    struct index_list
+    {
+    };
+
+    /// @brief the positions 0 to _N-1.
+    template <size_t _N, size_t... _Idx>
+    struct make_index_list
+        : make_index_list<_N-1, _N-1, 
+            _Idx...>
+    {
+    };
+
+    /// @brief make_index_list stop
+    template <size_t... _Idx>
+    struct make_index_list <0, _Idx...>
+    {
+        typedef index_list<_Idx...>
+            type;
+    };
+
+    /// @brief the strides of all the
+    /// fields, a constant array.
+    template <class _IdxTy, 
+        size_t... _Cards>
+    struct shape_strides;
+
+    /// @brief shape_strides expansion
+    template <size_t... _Idx, 
+        size_t... _Cards>
+    struct shape_strides <
+        index_list<_Idx...>, _Cards...>
+    {
+        static const size_t
+            values[sizeof...(_Cards)];
+    };
+
+    template <size_t... _Idx, 
+        size_t... _Cards>
+    const size_t shape_strides <
+        index_list<_Idx...>, _Cards...>
+        ::values[sizeof...(_Cards)]={
+            shape_stride<_Idx, 
+                _Cards...>::value... };
+
+    /// @brief compile-time layout of the
+    /// flat hypercubes, same interface as
+    /// cell_layout (totals excluded).
+    /// @note instantiated by the plugins
+    /// generated with the SHAPE define
+    /// (see plugin::create), carrying the
+    /// cardinalities observed in the data:
+    /// width, size and strides are then
+    /// constants (the strides a constant
+    /// array), folded into the loops over
+    /// the fields, whose bounds are 
+    /// constant as well.
+    template <size_t... _Cards>
+    struct fixed_shape
+    {
+        /// @brief construct empty.
+        fixed_shape()
+        {
+        }
+
+        /// @brief get the number of fields.
+        auto width() const
+            ->size_t
+        {
+            return sizeof...(_Cards);
+        }
+
+        /// @brief get the number of cells.
+        auto size() const
+            ->size_t
+        {
+            return shape_product<
+                _Cards...>::value;
+        }
+
+        /// @brief get the stride of the
+        /// field at position _F.
+        auto stride(
+            const size_t& _F) const
+            ->size_t
+        {
+            return shape_strides<
+                typename make_index_list<
+                    sizeof...(_Cards)>::type, 
+                        _Cards...>::values[_F];
+        }
+
+        /// @brief test whether the layout
+        /// computed from the data matches 
+        /// the compile-time one.
+        bool matches(
+            const cell_layout& _Layout) 
+            const
+        {
+            if (_Layout.width()!=width() ||
+                _Layout.size()!=size())
+                return false;
+
+            for (size_t f=0; f<width(); 
+                ++f)
+            {
+                if (_Layout.stride(f)!=
+                    stride(f))
+                    return false;
+            }
+
+            return true;
+        }
+    };
+
+    /// @brief cell offset and contribution
+    /// of a sampled record in one marginal.
+    struct radix_entry
+    {
+        size_t
+            _Offset;
+        record_contrib
+            _Contrib;
+    };
+
+    /// @brief two-phase aggregation of the
+    /// sampled records into a flat array of
+    /// cells larger than the cache.
+    /// @note phase 1 computes the cell
+    /// offset of each record in each marginal
+    /// of the lattice and scatters them into
+    /// buckets by the high bits of the
+    /// offset, each bucket covering a slice
+    /// of the cells fitting the L2 cache.
+    /// Phase 2 aggregates bucket by bucket,
+    /// while the slice of the cube stays
+    /// hot. Buckets cover disjoint cells and
+    /// are aggregated in parallel. The
+    /// records are processed in chunks, to
+    /// bound the size of the buffers, and
+    /// read from the packed code columns in
+    /// blocks. The shape is either the
+    /// cell_layout itself or a fixed_shape.
+    template <class _CellTy,
+        class _ShapeTy=cell_layout>
+    struct radix_aggregator
+    {
+        /// @brief construct with parameters.
+        /// @param _cLayout the cube layout.
+        /// @param _cShape the shape.
+        /// @param _cCodes the packed codes
+        /// and contributions of the records.
+        /// @param _cLattice the marginals.
+        radix_aggregator(
+            const cell_layout& _cLayout,
+            const _ShapeTy& _cShape,
+            const packed_columns& _cCodes,
+            const lattice& _cLattice)
+            : _Layout(_cLayout)
+            , _Shape(_cShape)
+            , _Codes(_cCodes)
+            , _Cases(_cLattice.cases())
+            , _TotOffsets(_Cases.size(), 0)
+            , _Shift(bucket_shift(
+                _cShape.size()))
+        {
+            for (size_t c=0; c<_Cases.size();
+                ++c)
+            {// offset of the total codes
+                // of each marginal
+                for (size_t f=0; f<_Shape
+                    .width(); ++f)
+                {
+                    if (_Cases[c] &
+                        ((lattice::case_type)1<<f))
+                        _TotOffsets[c]+=
+                            _Layout.total(f)*
+                                _Shape.stride(f);
+                }
+            }
+        }
+
+        /// @brief aggregate the sampled
+        /// records into the cells.
+        /// @param _Marks sampled flags, one
+        /// for each record.
+        /// @param _Threads number of threads.
+        /// @param _Cells the flat array of
+        /// cells, sized as the layout.
+        void update(
+            const std::vector<bool>& _Marks,
+            const size_t& _Threads,
+            std::vector<_CellTy>& _Cells)
+            const
+        {
+            const size_t
+                _RecordsSz(_Marks.size()),
+                _Buckets(1+((_Shape.size()-1)
+                    >>_Shift));
+
+            if (_Buckets<2)
+            {// the cube fits the cache
+                block_buffer _Buf(*this);
+
+                for (size_t _Beg=0; _Beg<
+                    _RecordsSz; _Beg+=_Block)
+                {
+                    const size_t _N(std::min(
+                        _Block, _RecordsSz-_Beg));
+
+                    offsets(_Beg, _N, _Buf);
+
+                    for (size_t j=0; j<_N; ++j)
+                    {
+                        if (! _Marks[_Beg+j])
+                            continue;
+
+                        for (size_t c=0; c<_Cases
+                            .size(); ++c)
+                            _Cells[_Buf._Off[
+                                c*_Block+j]].update(
+                                _Codes.contrib(_Beg+j));
+                    }
+                }
+
+                return;
+            }
+
+            const size_t
+                _Parts(std::max<size_t>(1,
+                    _Threads)),
+                _Chunk(std::max<size_t>(_Block,
+                    _ChunkEntries/_Cases.size()));
+
+            // per thread entries and
+            // histograms, partitioned
+            // entries, bucket bounds
+            std::vector<std::vector<
+                radix_entry>>
+                _Local(_Parts);
+            std::vector<std::vector<
+                size_t>>
+                _Pos(_Parts, std::vector<
+                    size_t>(_Buckets));
+            std::vector<radix_entry>
+                _Part;
+            std::vector<size_t>
+                _Bounds(_Buckets+1);
+
+            for (size_t _Beg=0; _Beg<
+                _RecordsSz; _Beg+=_Chunk)
+            {
+                const size_t
+                    _End(std::min(_RecordsSz,
+                        _Beg+_Chunk)),
+                    _Sz(_End-_Beg);
+
+                // phase 1a: offsets and
+                // histograms
+                #pragma omp parallel for \
+                    num_threads(_Parts) \
+                    schedule(static, 1)
+                for (size_t p=0; p<_Parts;
+                    ++p)
+                {
+                    fill(_Marks,
+                        _Beg+_Sz*p/_Parts,
+                        _Beg+_Sz*(p+1)/_Parts,
+                        _Local[p], _Pos[p]);
+                }
+
+                // bucket bounds and write
+                // positions of each thread
+                size_t _Total(0);
+
+                for (size_t b=0; b<_Buckets;
+                    ++b)
+                {
+                    _Bounds[b]=_Total;
+
+                    for (size_t p=0; p<_Parts;
+                        ++p)
+                    {
+                        const size_t
+                            _N(_Pos[p][b]);
+
+                        _Pos[p][b]=_Total;
+                        _Total+=_N;
+                    }
+                }
+
+                _Bounds[_Buckets]=_Total;
+                _Part.resize(_Total);
+
+                // phase 1b: scatter
+                #pragma omp parallel for \
+                    num_threads(_Parts) \
+                    schedule(static, 1)
+                for (size_t p=0; p<_Parts;
+                    ++p)
+                {
+                    scatter(_Local[p],
+                        _Pos[p], _Part);
+                }
+
+                // phase 2: aggregate each
+                // bucket
+                #pragma omp parallel for \
+                    num_threads(_Parts) \
+                    schedule(dynamic)
+                for (size_t b=0; b<_Buckets;
+                    ++b)
+                {
+                    aggregate(_Part,
+                        _Bounds[b],
+                        _Bounds[b+1],
+                        _Cells);
+                }
+            }
+        }
+
+    private:
+
+        /// @brief buffers of the offsets
+        /// of a block of records.
+        struct block_buffer
+        {
+            block_buffer(
+                const radix_aggregator& _A)
+                : _Contrib(_A._Shape.width()
+                    *_Block)
+                , _Off(_A._Cases.size()
+                    *_Block)
+            {
+            }
+
+            // offset contributions of
+            // each field, field by field
+            std::vector<size_t>
+                _Contrib;
+            // offsets of each marginal,
+            // marginal by marginal
+            std::vector<size_t>
+                _Off;
+        };
+
+        /// @brief compute the offsets of
+        /// the _N records starting from
+        /// _Beg in each marginal.
+        /// @note the code columns are 
+        /// unpacked straight into offset
+        /// contributions, then summed up
+        /// for each marginal.
+        void offsets(
+            const size_t& _Beg,
+            const size_t& _N,
+            block_buffer& _Buf)
+            const
+        {
+            const size_t _Width(
+                _Shape.width());
+
+            for (size_t f=0; f<_Width; ++f)
+                _Codes.unpack(f, _Beg, _N,
+                    _Shape.stride(f),
+                        &_Buf._Contrib[
+                            f*_Block]);
+
+            for (size_t c=0; c<_Cases.size();
+                ++c)
+            {
+                size_t* _Off(
+                    &_Buf._Off[c*_Block]);
+
+                std::fill(_Off, _Off+_N,
+                    _TotOffsets[c]);
+
+                for (size_t f=0; f<_Width;
+                    ++f)
+                {
+                    if (_Cases[c] &
+                        ((lattice::case_type)1<<f))
+                        continue;
+
+                    const size_t* _Con(
+                        &_Buf._Contrib[f*_Block]);
+
+                    for (size_t j=0; j<_N; ++j)
+                        _Off[j]+=_Con[j];
+                }
+            }
+        }
+
+        /// @brief phase 1a: fill the
+        /// entries of records _Beg to _End
+        /// and count them by bucket.
+        void fill(
+            const std::vector<bool>& _Marks,
+            const size_t& _Beg,
+            const size_t& _End,
+            std::vector<radix_entry>& _Out,
+            std::vector<size_t>& _Hist)
+            const
+        {
+            std::fill(_Hist.begin(),
+                _Hist.end(), 0);
+
+            _Out.clear();
+
+            block_buffer _Buf(*this);
+
+            for (size_t i=_Beg; i<_End; 
+                i+=_Block)
+            {
+                const size_t _N(std::min(
+                    _Block, _End-i));
+
+                offsets(i, _N, _Buf);
+
+                for (size_t j=0; j<_N; ++j)
+                {
+                    if (! _Marks[i+j])
+                        continue;
+
+                    for (size_t c=0; c<_Cases
+                        .size(); ++c)
+                    {
+                        radix_entry _E;
+                        _E._Offset=_Buf._Off[
+                            c*_Block+j];
+                        _E._Contrib=_Codes
+                            .contrib(i+j);
+
+                        _Out.push_back(_E);
+
+                        ++_Hist[_E._Offset
+                            >>_Shift];
+                    }
+                }
+            }
+        }
+
+        /// @brief phase 1b: copy the entries
+        /// to their buckets.
+        void scatter(
+            const std::vector<radix_entry>& _In,
+            std::vector<size_t>& _Pos,
+            std::vector<radix_entry>& _Out)
+            const
+        {
+            const size_t _Sz(_In.size());
+
+            for (size_t j=0; j<_Sz; ++j)
+            {
+                if (j+_Prefetch<_Sz)
+                    __builtin_prefetch(&_Out[
+                        _Pos[_In[j+_Prefetch]
+                            ._Offset>>_Shift]], 1);
+
+                _Out[_Pos[_In[j]._Offset
+                    >>_Shift]++]=_In[j];
+            }
+        }
+
+        /// @brief phase 2: update the cells
+        /// of the entries _Beg to _End.
+        void aggregate(
+            const std::vector<radix_entry>& _In,
+            const size_t& _Beg,
+            const size_t& _End,
+            std::vector<_CellTy>& _Cells)
+            const
+        {
+            for (size_t j=_Beg; j<_End; ++j)
+            {
+                if (j+_Prefetch<_End)
+                    __builtin_prefetch(&_Cells[
+                        _In[j+_Prefetch]._Offset], 1);
+
+                _Cells[_In[j]._Offset]
+                    .update(_In[j]._Contrib);
+            }
+        }
+
+        /// @brief get the number of low
+        /// offset bits addressing the cells
+        /// of one bucket.
+        static auto bucket_shift(
+            const size_t& _Size)
+            ->size_t
+        {
+            long _L2(::sysconf(
+                _SC_LEVEL2_CACHE_SIZE));
+
+            if (_L2<=0)
+                _L2=_DefaultL2;
+
+            // cells fitting the cache
+            size_t _Shift(0);
+
+            while ((sizeof(_CellTy)<<
+                (_Shift+1))<=(size_t)_L2)
+                ++_Shift;
+
+            // limit the fan-out of
+            // the scatter
+            while ((_Size>>_Shift)>
+                _MaxBuckets)
+                ++_Shift;
+
+            return _Shift;
+        }
+
+        static const long
+            _DefaultL2=256*1024;
+        static const size_t
+            _MaxBuckets=4096;
+        static const size_t
+            _ChunkEntries=1<<20;
+        static const size_t
+            _Prefetch=8;
+        static const size_t
+            _Block=256;
+
+        const cell_layout&
+            _Layout;
+        const _ShapeTy&
+            _Shape;
+        const packed_columns&
+            _Codes;
+        const lattice::container&
+            _Cases;
+        std::vector<size_t>
+            _TotOffsets;
+        size_t
+            _Shift;
+    };
+
+    template <class _CellTy, class _ShapeTy>
+        const long 
+        radix_aggregator<_CellTy, _ShapeTy>::_DefaultL2;
+    template <class _CellTy, class _ShapeTy>
+        const size_t 
+        radix_aggregator<_CellTy, _ShapeTy>::_MaxBuckets;
+    template <class _CellTy, class _ShapeTy>
+        const size_t 
+        radix_aggregator<_CellTy, _ShapeTy>::_ChunkEntries;
+    template <class _CellTy, class _ShapeTy>
+        const size_t 
+        radix_aggregator<_CellTy, _ShapeTy>::_Prefetch;
+    template <class _CellTy, class _ShapeTy>
+        const size_t 
+        radix_aggregator<_CellTy, _ShapeTy>::_Block;
+}
@@ -1,9 +1,36 @@
 #pragma once
+#include <cassert>
+#include <cmath>
+#include <limits>
 #include <random>
 #include "random_distp.hpp"
 
 namespace confly
 {
+	/// @brief draw a real number in
+	/// [0,1) with the supplied uniform
+	/// distribution.
+	template <class _EngTy, class _DistTy>
+	inline auto unit_draw(
+		_EngTy& _RE,
+		_DistTy& _Unif)
+		->typename _DistTy::result_type
+	{
+		return _Unif(_RE);
+	}
+
+	/// @brief draw a real number in
+	/// [0,1): 53 bits of a single draw
+	/// of xoshiro256**.
+	template <class _DistTy>
+	inline auto unit_draw(
+		xoshiro256& _RE,
+		_DistTy&)
+		->typename _DistTy::result_type
+	{
+		return _RE.unit();
+	}
+
 	/// @brief template uniform distribution 
 	/// class for integer and real value types
 	template <class T>
@@ -122,7 +149,7 @@ namespace confly
 			->value_type
 		{
 			const value_type _Q(
-				_RealUnif(_RE));
+				unit_draw(_RE, _RealUnif));
 
 			if (_Q < 0.5)
 				return _Mu + 
@@ -138,6 +165,27 @@ namespace confly
 				return _Mu;
 		}
 
+		/// @brief draw a batch of values,
+		/// the same as _N draws in a row.
+		/// @param _RE random generator.
+		/// @param _Out destination, room
+		/// for _N values.
+		/// @param _N number of values.
+		/// @note scalar: the batch saves
+		/// the calls per value, it is not
+		/// vectorized (a vector log would
+		/// not give the same values as
+		/// std::log, nor the same noise).
+		template <class _EngTy>
+		void fill(
+			_EngTy& _RE,
+			value_type* _Out,
+			const size_t& _N)
+		{
+			for (size_t i=0; i<_N; ++i)
+				_Out[i]=(*this)(_RE);
+		}
+
 	private:
 
 		value_type 
@@ -149,6 +197,21 @@ namespace confly
 	};
 
 	/// @brief Geometric distribution class
+	/// @note two-sided: the CDF is 
+	/// a^-z/(1+a) for z<0 and 
+	/// 1-a^(z+1)/(1+a) otherwise, with
+	/// a=exp(-eps). The draw inverts it
+	/// in closed form, then settles the
+	/// result on the same comparisons
+	/// as the step by step walk (see
+	/// walk()), so that both return the
+	/// same value for the same uniform.
+	/// The inversion follows the CDF as
+	/// rounded, so the settling takes
+	/// a step at most (asserted); the
+	/// values the CDF rounds to 0 or 1
+	/// at, where the log is unbounded,
+	/// are cached.
 	struct geometric_distribution
 	{
 		/// @brief value type
@@ -182,6 +245,11 @@ namespace confly
 			const param_type&,
     		const param_type& _cEps)
 			: _Eps(_cEps)
+			, _A(std::exp(-_cEps))
+			, _G0(cgeom(0))
+			, _Gm1(cgeom(-1))
+			, _ZTop(bound(true))
+			, _ZBot(bound(false))
 			, _RealUnif(0.0, 1.0)
 		{
 		}
@@ -194,6 +262,11 @@ namespace confly
 			const param_type& _cEps)
         {
             _Eps=_cEps;
+            _A=std::exp(-_cEps);
+            _G0=cgeom(0);
+            _Gm1=cgeom(-1);
+            _ZTop=bound(true);
+            _ZBot=bound(false);
         }
 
 		/// @brief draw value
@@ -205,40 +278,228 @@ namespace confly
 			_EngTy& _RE)
 			->value_type
 		{
-			const real_type _P(
-				_RealUnif(_RE));
+			return inverse(
+				unit_draw(_RE, _RealUnif));
+		}
+
+		/// @brief draw a batch of values,
+		/// the same as _N draws in a row.
+		/// @param _RE random generator.
+		/// @param _Out destination, room
+		/// for _N values.
+		/// @param _N number of values.
+		template <class _EngTy>
+		void fill(
+			_EngTy& _RE,
+			value_type* _Out,
+			const size_t& _N)
+		{
+			for (size_t i=0; i<_N; ++i)
+				_Out[i]=inverse(unit_draw(
+					_RE, _RealUnif));
+		}
+
+		/// @brief draw value walking
+		/// the CDF one step at a time
+		/// (reference implementation).
+		/// @return extracted value
+		/// @note cost proportional to
+		/// the value drawn.
+		template <class _EngTy>
+		auto walk( 
+			_EngTy& _RE)
+			->value_type
+		{
+			return settle(
+				unit_draw(_RE, _RealUnif), 0,
+					std::numeric_limits<
+						value_type>::max());
+		}
+
+		/// @brief invert the CDF.
+		/// @param _P uniform in [0,1].
+		/// @return the value whose CDF
+		/// interval holds _P.
+		auto inverse(
+			const real_type& _P)
+			const
+			->value_type
+		{
+			if (! (_Eps>0))
+				return settle(_P, 0,
+					std::numeric_limits<
+						value_type>::max());
+
+			// the mode, most of the
+			// draws for large epsilon
+			if (_P > 0.5 ? _P<=_G0 : 
+				_P>=_Gm1)
+				return 0;
+
+			// beyond the cached bounds 
+			// the CDF rounds to 0 or 1:
+			// the walk stops there for
+			// _P=0 (infinite log) or 1
+			value_type _Z(0);
+
+			if (_P > 0.5) 
+			{// a^(z+1) <= (1-P)(1+a)
+				const real_type _T(
+					-std::log(upper(_P))
+						/_Eps);
+
+				if (_T>1)
+					_Z=(value_type)std::min(
+						std::ceil(_T)-1, 
+							(real_type)_ZTop);
+			}
 
-			int _Z(0);
+			else
+			{// a^(1-z) <= P(1+a)
+				const real_type _S(
+					-std::log(_P*(1+_A))
+						/_Eps);
+
+				if (_S>1)
+					_Z=-(value_type)std::min(
+						std::ceil(_S)-1, 
+							-(real_type)_ZBot);
+			}
+
+			// rounding of log vs pow
+			return settle(_P, _Z, 
+				_SettleSteps);
+		}
 
+	private:
+
+		/// @brief most steps the closed
+		/// form is settled by.
+		static const value_type
+			_SettleSteps=1;
+
+		/// @brief walk from _Z to the 
+		/// value the walk from 0 stops at.
+		/// @param _Steps most steps taken,
+		/// asserted to be enough.
+		auto settle(
+			const real_type& _P,
+			value_type _Z,
+			value_type _Steps)
+			const
+			->value_type
+		{
 			if (_P > 0.5) 
 			{
-				while (_P>cgeom(_Z)) 
+				while (_Z>0 && 
+					_P<=cgeom(_Z-1) &&
+					0<_Steps--)
+				{
+					--_Z;
+				}
+
+				while (_P>cgeom(_Z) &&
+					0<_Steps--) 
 				{
 					++_Z;
 				}
+
+				assert(! (_Z>0 && 
+					_P<=cgeom(_Z-1)) &&
+					! (_P>cgeom(_Z)));
 			} 
 
 			else 
 			{
-				while (_P<cgeom(_Z-1))
+				while (_Z<0 && 
+					_P>=cgeom(_Z) &&
+					0<_Steps--)
+				{
+					++_Z;
+				}
+
+				while (_P<cgeom(_Z-1) &&
+					0<_Steps--)
 				{
 					--_Z;
 				}
+
+				assert(! (_Z<0 && 
+					_P>=cgeom(_Z)) &&
+					! (_P<cgeom(_Z-1)));
 			}
 
 			return _Z;
 		}
 
-	private:
+		/// @brief the largest a^(z+1) the
+		/// CDF, as rounded by cgeom, is 
+		/// not below _P for: (1-P)(1+a),
+		/// but exact next to 1, where the
+		/// CDF rounds to one value for
+		/// many z (as many as 0.7/eps).
+		/// @param _P uniform in (0.5,1].
+		auto upper(
+			const real_type& _P)
+			const
+			->real_type
+		{
+			const real_type _B(1+_A);
+
+			// the least numerator 1+a-x
+			// of the CDF not below _P
+			real_type _N(_P*_B);
+
+			while (_N/_B>=_P)
+				_N=std::nextafter(_N, 0.0);
+
+			while (_N/_B<_P)
+				_N=std::nextafter(_N, _B);
+
+			// the x the numerator rounds
+			// to _N (or above) for
+			return (_B-_N) + (_N-std::
+				nextafter(_N, 0.0))/2;
+		}
+
+		/// @brief the first value from 0
+		/// on where the CDF rounds to 1
+		/// (_BUp) or below which it rounds
+		/// to 0, i.e. where the walk stops
+		/// for _P=1 or _P=0, by bisection.
+		/// @note bounded to half the int
+		/// range, for epsilon next to 0.
+		auto bound(
+			const bool _BUp)
+			const
+			->value_type
+		{
+			value_type _Lo(0), _Hi(
+				std::numeric_limits<
+					value_type>::max()/2);
+
+			while (_Lo<_Hi)
+			{
+				const value_type _Mid(
+					_Lo+(_Hi-_Lo)/2);
+
+				if (_BUp ? 
+					cgeom(_Mid)>=1 :
+					cgeom(-_Mid-1)<=0)
+					_Hi=_Mid;
+
+				else
+					_Lo=_Mid+1;
+			}
+
+			return _BUp ? _Lo : -_Lo;
+		}
 
 		auto cgeom(
 			const value_type& _Z)
 			const
 			->real_type 
 		{
-			const real_type 
-				_A(std::exp(-_Eps));
-
 			real_type
 				_G(0.0);
 
@@ -259,6 +520,16 @@ namespace confly
 
 		real_type
 			_Eps;
+		real_type
+			_A; // exp(-eps)
+		real_type
+			_G0; // CDF at 0
+		real_type
+			_Gm1; // CDF at -1
+		value_type
+			_ZTop; // CDF 1 from here on
+		value_type
+			_ZBot; // CDF 0 below here
 		real_distribution_type
 			_RealUnif;
 	};
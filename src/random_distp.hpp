@@ -56,9 +56,10 @@ namespace __detail
 	};
 
 
-	template <class _RealType, size_t __bits>
+	template <class _RealType, size_t __bits,
+		class _URNG>
 	auto generate_canonical_t(
-		confly::mersenne_twister& __g)
+		_URNG& __g)
 		->_RealType
 	{
 		// see https://github.com/llvm-mirror/libcxx/blob/master/include/random
@@ -100,10 +101,10 @@ namespace __detail
 		size_t __bits, class _URNG>
 	inline auto generate_canonical(_URNG& __g)
 		->_RealType
-	{// force build failure if using 
-		// generators different from MT19937
+	{// generators drawing 32 bits, 
+		// as MT19937 (e.g. philox4x32)
 		return generate_canonical_t<
-			_RealType, __bits>(__g);
+			_RealType, __bits, _URNG>(__g);
 	}
 
 	template<typename _Engine, typename _DInputType>
@@ -93,6 +93,64 @@ namespace confly
                 _Cont.insert(_D(_DRE));
         }
 
+        /// @brief draw multiple unique values,
+        /// flagging them in a vector of marks
+        /// instead of inserting them in a set.
+        /// @param _1 the first parameter
+        /// of the distribution.
+        /// @param _2 the second parameter
+        /// of the distribution.
+        /// @param _N how many.
+        /// @param _Marks destination vector,
+        /// indexed by the drawn value.
+        /// @note the sequence of draws is
+        /// the same of the std::set overload,
+        /// thus the same values are drawn.
+        /// @note _Marks gets resized to
+        /// accomodate _2+1 flags.
+        void mark(
+            const param_type& _1,
+            const param_type& _2,
+            const size_t& _N,
+            std::vector<bool>& _Marks)
+        {// draw _N unique
+            mark(_1, _2, _N, _Marks, _DRE);
+        }
+
+        /// @brief as mark(), drawing from
+        /// the supplied engine.
+        /// @param _RE the engine, e.g.
+        /// the stream of a cube.
+        template <class _EngTy>
+        void mark(
+            const param_type& _1,
+            const param_type& _2,
+            const size_t& _N,
+            std::vector<bool>& _Marks,
+            _EngTy& _RE)
+        {// draw _N unique
+            // warn: this function will hang
+            // if the distribution domain 
+            // is smaller than _N
+            distribution_type
+                _D(_1, _2);
+
+            _Marks.assign(_2+1, false);
+
+            for (size_t _Sz=0; _Sz<_N; )
+            {
+                const value_type 
+                    _Val(_D(_RE));
+
+                if (! _Marks[_Val])
+                {
+                    _Marks[_Val]=true;
+
+                    ++_Sz;
+                }
+            }
+        }
+
         /// @brief draw multiple values.
         /// @note overload for arbitrary
         /// container destinations implementing
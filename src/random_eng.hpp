@@ -1,5 +1,16 @@
 #pragma once
 #include <random>
+#include <cstdint>
+
+// the standard distributions of
+// GCC >= 4.8 need the bounds of the
+// engines as constant expressions
+#if __GNUC__ > 4 || (__GNUC__ == 4 && \
+	__GNUC_MINOR__ >= 6)
+#define ENGINE_CONSTEXPR constexpr
+#else
+#define ENGINE_CONSTEXPR
+#endif
 
 namespace confly
 {
@@ -30,4 +41,295 @@ namespace confly
     {
         return _DRE.max();
     }
+
+    /// @brief splitmix64 finalizer: a 
+    /// bijective mix of the 64 bits.
+    inline auto splitmix64(
+        uint64_t _X)
+        ->uint64_t
+    {
+        _X+=0x9e3779b97f4a7c15ULL;
+        _X=(_X^(_X>>30))*0xbf58476d1ce4e5b9ULL;
+        _X=(_X^(_X>>27))*0x94d049bb133111ebULL;
+
+        return _X^(_X>>31);
+    }
+
+    /// @brief stateless draw keyed by 
+    /// a seed, a stream and an ordinal,
+    /// e.g. (seed, cube, record): the
+    /// same key always yields the same
+    /// 64 bits, whatever the order of 
+    /// the draws.
+    inline auto keyed_draw(
+        const uint64_t& _Seed,
+        const uint64_t& _Stream,
+        const uint64_t& _Ordinal)
+        ->uint64_t
+    {
+        return splitmix64(splitmix64(
+            splitmix64(_Seed)^_Stream)
+                ^_Ordinal);
+    }
+
+    /// @brief keyed draw as a real
+    /// number in [0,1), 53 bits.
+    inline auto keyed_unit(
+        const uint64_t& _Seed,
+        const uint64_t& _Stream,
+        const uint64_t& _Ordinal)
+        ->double
+    {
+        return (keyed_draw(_Seed, _Stream,
+            _Ordinal)>>11)*(1.0/
+                9007199254740992.0);
+    }
+
+    /// @brief purposes of the streams
+    /// of a cube (see philox4x32).
+    enum stream_purpose
+    {
+        STREAM_SAMPLE=1,
+        STREAM_DPF=2,
+        STREAM_DPG=3
+    };
+
+    /// @brief Philox4x32-10 counter-based
+    /// engine (Salmon et al., "Parallel
+    /// random numbers: as easy as 1, 2, 3",
+    /// SC11), 32 bits per draw.
+    /// @note the stream is keyed by the 
+    /// seed, a cube and a purpose: each
+    /// block of 4 draws is the bijection
+    /// of its counter (block ordinal, 
+    /// cube, purpose) under the seed, so
+    /// that the draws of a cube do not
+    /// depend on any other draw, nor on
+    /// the thread drawing them.
+    /// @note no constructor, so that the
+    /// engine can be thread private.
+    struct philox4x32
+    {
+        /// @brief result type
+        typedef uint32_t
+            result_type;
+
+        /// @brief smallest value drawn
+        static ENGINE_CONSTEXPR 
+            result_type min()
+        {
+            return 0;
+        }
+
+        /// @brief largest value drawn
+        static ENGINE_CONSTEXPR 
+            result_type max()
+        {
+            return 0xffffffffU;
+        }
+
+        /// @brief start a stream.
+        /// @param _Seed the seed (key).
+        /// @param _Cube the ordinal of
+        /// the cube.
+        /// @param _Purpose the purpose.
+        void seed(
+            const uint64_t& _Seed,
+            const uint64_t& _Cube,
+            const stream_purpose& _Purpose)
+        {
+            _Key[0]=(uint32_t)_Seed;
+            _Key[1]=(uint32_t)(_Seed>>32);
+
+            _Ctr[0]=0;
+            _Ctr[1]=0;
+            _Ctr[2]=(uint32_t)_Cube;
+            _Ctr[3]=((uint32_t)(_Cube>>32)
+                <<8)|(uint32_t)_Purpose;
+
+            _Idx=4;
+        }
+
+        /// @brief draw 32 bits.
+        auto operator()()
+            ->result_type
+        {
+            if (4==_Idx)
+            {// next block
+                block(_Ctr, _Key, _Out);
+
+                if (0==++_Ctr[0])
+                    ++_Ctr[1];
+
+                _Idx=0;
+            }
+
+            return _Out[_Idx++];
+        }
+
+        /// @brief the bijection of a
+        /// counter under a key, 10 rounds.
+        /// @param _In the counter.
+        /// @param _K the key.
+        /// @param _Res destination.
+        static void block(
+            const uint32_t* _In,
+            const uint32_t* _K,
+            uint32_t* _Res)
+        {
+            uint32_t 
+                _C0(_In[0]), _C1(_In[1]), 
+                _C2(_In[2]), _C3(_In[3]),
+                _K0(_K[0]), _K1(_K[1]);
+
+            for (size_t r=0; r<10; ++r)
+            {
+                const uint64_t 
+                    _P0((uint64_t)0xD2511F53U*_C0),
+                    _P1((uint64_t)0xCD9E8D57U*_C2);
+
+                const uint32_t 
+                    _Hi0((uint32_t)(_P0>>32)),
+                    _Hi1((uint32_t)(_P1>>32));
+
+                _C0=_Hi1^_C1^_K0;
+                _C2=_Hi0^_C3^_K1;
+                _C1=(uint32_t)_P1;
+                _C3=(uint32_t)_P0;
+
+                // bump the key
+                _K0+=0x9E3779B9U;
+                _K1+=0xBB67AE85U;
+            }
+
+            _Res[0]=_C0;
+            _Res[1]=_C1;
+            _Res[2]=_C2;
+            _Res[3]=_C3;
+        }
+
+    private:
+
+        uint32_t
+            _Key[2];
+        uint32_t
+            _Ctr[4];
+        uint32_t
+            _Out[4];
+        size_t
+            _Idx;
+    };
+
+    /// @brief xoshiro256** engine (Blackman
+    /// and Vigna, "Scrambled linear 
+    /// pseudorandom number generators",
+    /// 2021), 64 bits per draw.
+    /// @note the stream of a seed, a cube
+    /// and a purpose starts from the state
+    /// expanded by splitmix64 from their
+    /// keyed draw (see keyed_draw()).
+    /// @note no constructor, so that the
+    /// engine can be thread private.
+    struct xoshiro256
+    {
+        /// @brief result type
+        typedef uint64_t
+            result_type;
+
+        /// @brief smallest value drawn
+        static ENGINE_CONSTEXPR 
+            result_type min()
+        {
+            return 0;
+        }
+
+        /// @brief largest value drawn
+        static ENGINE_CONSTEXPR 
+            result_type max()
+        {
+            return ~(result_type)0;
+        }
+
+        /// @brief start a stream.
+        /// @param _Seed the seed.
+        /// @param _Cube the ordinal of
+        /// the cube.
+        /// @param _Purpose the purpose.
+        void seed(
+            const uint64_t& _Seed,
+            const uint64_t& _Cube,
+            const stream_purpose& _Purpose)
+        {
+            uint64_t _X(keyed_draw(_Seed, 
+                _Cube, _Purpose));
+
+            for (size_t i=0; i<4; ++i,
+                _X+=0x9e3779b97f4a7c15ULL)
+                _S[i]=splitmix64(_X);
+        }
+
+        /// @brief set the state (tests).
+        void state(
+            const uint64_t* _cS)
+        {
+            for (size_t i=0; i<4; ++i)
+                _S[i]=_cS[i];
+        }
+
+        /// @brief draw 64 bits.
+        auto operator()()
+            ->result_type
+        {
+            const uint64_t _Res(
+                rotl(_S[1]*5, 7)*9);
+
+            const uint64_t _T(
+                _S[1]<<17);
+
+            _S[2]^=_S[0];
+            _S[3]^=_S[1];
+            _S[1]^=_S[2];
+            _S[0]^=_S[3];
+
+            _S[2]^=_T;
+
+            _S[3]=rotl(_S[3], 45);
+
+            return _Res;
+        }
+
+        /// @brief draw a real number in
+        /// [0,1), the 53 high bits of a
+        /// single draw.
+        auto unit()
+            ->double
+        {
+            return (operator()()>>11)*(1.0/
+                9007199254740992.0);
+        }
+
+    private:
+
+        static auto rotl(
+            const uint64_t& _X,
+            const int& _K)
+            ->uint64_t
+        {
+            return (_X<<_K)|(_X>>(64-_K));
+        }
+
+        uint64_t
+            _S[4];
+    };
+
+#ifdef XOSHIRO
+    // streams of the cubes drawn
+    // by xoshiro256** (see plugin
+    // defines)
+    typedef xoshiro256
+        stream_engine;
+#else
+    typedef philox4x32
+        stream_engine;
+#endif
 }
\ No newline at end of file
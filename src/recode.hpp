@@ -0,0 +1,222 @@
+#pragma once
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace confly
+{
+    /// @brief a recode of a field of the
+    /// microdata, applied to the values as
+    /// read, before they are aggregated, so
+    /// that the hypercubes hold derived codes
+    /// of bounded cardinality (see config
+    /// "micro" "recode").
+    /// @note three kinds of recode:
+    /// - range binning: the code is the
+    ///   number of cut points not greater
+    ///   than the value (0 to #cuts),
+    /// - value to group map: the listed
+    ///   values are replaced by their group,
+    ///   the others by a default group, or
+    ///   kept if no default is given,
+    /// - hierarchical code truncation: the
+    ///   leading characters of the value
+    ///   are kept (e.g. NUTS3 to NUTS2).
+    struct recode
+    {
+        /// @brief kind of recode
+        enum kind_type
+        {
+            BINS,
+            MAP,
+            TRUNCATE
+        };
+
+        /// @brief construct empty.
+        recode()
+            : _Field(0)
+            , _Kind(BINS)
+            , _Cuts()
+            , _Map()
+            , _Other()
+            , _Len(0)
+        {
+        }
+
+        /// @brief recode a column of values,
+        /// the missing (empty) ones are kept.
+        /// @param _Col the values of the
+        /// field, one for each record.
+        void apply(
+            std::vector<std::string>& _Col)
+            const
+        {
+            for (size_t i=0; i<_Col.size();
+                ++i)
+            {
+                std::string& _Val(_Col[i]);
+
+                if (_Val.empty())
+                    continue;
+
+                switch (_Kind)
+                {
+                case BINS:
+                    _Val=bin(_Val);
+                    break;
+
+                case MAP:
+                    {
+                        auto F(_Map.find(_Val));
+
+                        if (F!=_Map.end())
+                            _Val=F->second;
+
+                        else if (! _Other
+                            .empty())
+                            _Val=_Other;
+                    }
+                    break;
+
+                case TRUNCATE:
+                    if (_Val.size()>_Len)
+                        _Val.resize(_Len);
+                    break;
+                }
+            }
+        }
+
+        /// @brief position of the field
+        /// in the microdata record
+        size_t
+            _Field;
+        /// @brief kind of recode
+        kind_type
+            _Kind;
+        /// @brief cut points of the bins,
+        /// in increasing order
+        std::vector<double>
+            _Cuts;
+        /// @brief groups of the values
+        std::map<std::string,
+            std::string>
+            _Map;
+        /// @brief group of the values
+        /// not listed, empty to keep them
+        std::string
+            _Other;
+        /// @brief leading characters kept
+        size_t
+            _Len;
+
+    private:
+
+        auto bin(
+            const std::string& _Val)
+            const
+            ->std::string
+        {
+            const double _X(std::strtod(
+                _Val.c_str(), 0));
+
+            std::ostringstream _OSS;
+
+            _OSS << (std::upper_bound(
+                _Cuts.begin(), _Cuts.end(),
+                    _X) - _Cuts.begin());
+
+            return _OSS.str();
+        }
+    };
+
+    /// @brief type of the list of recodes
+    typedef std::vector<
+        recode>
+        recode_list;
+
+    /// @brief number of lines recoded
+    /// in a single pass
+    static const size_t
+        _RecodeBatch(1<<16);
+
+    /// @brief recode a batch of lines of
+    /// the microdata file: the lines are
+    /// split into columns, each recode is
+    /// applied to its column in a single
+    /// pass, then the lines are joined back.
+    /// @param _Recodes the recodes.
+    /// @param _Sep the separator.
+    /// @param _Lines the lines, replaced
+    /// by the recoded ones.
+    inline void recode_lines(
+        const recode_list& _Recodes,
+        const char& _Sep,
+        std::vector<std::string>& _Lines)
+    {
+        const size_t _Sz(_Lines.size());
+
+        std::vector<std::vector<
+            std::string>> _Cols;
+
+        for (size_t i=0; i<_Sz; ++i)
+        {// split, column-major
+            std::string& _Ln(_Lines[i]);
+
+            if (! _Ln.empty() &&
+                '\r'==_Ln[_Ln.size()-1])
+                _Ln.resize(_Ln.size()-1);
+
+            size_t _Beg(0), f(0);
+
+            for (;; ++f)
+            {
+                const size_t _End(
+                    _Ln.find(_Sep, _Beg));
+
+                if (f==_Cols.size())
+                    _Cols.push_back(std::vector<
+                        std::string>(_Sz));
+
+                _Cols[f][i]=_Ln.substr(_Beg,
+                    _End==std::string::npos ?
+                        std::string::npos :
+                        _End-_Beg);
+
+                if (_End==std::string::npos)
+                    break;
+
+                _Beg=_End+1;
+            }
+        }
+
+        for (size_t r=0; r<_Recodes.size();
+            ++r)
+        {// column pass
+            if (_Recodes[r]._Field<
+                _Cols.size())
+                _Recodes[r].apply(_Cols[
+                    _Recodes[r]._Field]);
+        }
+
+        for (size_t i=0; i<_Sz; ++i)
+        {// join
+            if (_Lines[i].empty())
+                continue;
+
+            std::string& _Ln(_Lines[i]);
+
+            _Ln.clear();
+
+            for (size_t f=0; f<_Cols.size();
+                ++f)
+            {
+                if (f) _Ln.push_back(_Sep);
+
+                _Ln.append(_Cols[f][i]);
+            }
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <cassert>
 #include "ptable.hpp"
 #include "random_dist.hpp"
 
@@ -21,6 +22,17 @@ namespace confly
     typedef double
         cellkey_key_type;
 
+#ifdef FIXED_RKEY
+    // fixed-point record keys: 32 
+    // bits, summed modulo 2^32 by
+    // wrap-around (see plugin defines)
+    typedef uint32_t
+        recordkey_sum_type;
+#else
+    typedef unsigned long long
+        recordkey_sum_type;
+#endif
+
     typedef integral_noise_type
         cellkey_value_type;
 
@@ -36,14 +48,221 @@ namespace confly
     typedef integral_noise_type
         geometric_value_type;
 
+#ifdef MAGNITUDE
+    // magnitude tables: sum up the
+    // field at tuple position MAGNITUDE
+    // (see plugin defines), as 64 bits
+    // integers if the field is integral
+    // (exact whatever the order of the
+    // sums), in double otherwise
+    typedef std::tuple_element<MAGNITUDE,
+        std::tuple<PARAMS>>::type
+        magnitude_field_type;
+
+    typedef std::conditional<
+        std::is_integral<
+            magnitude_field_type>::value,
+        long long, double>::type
+        magnitude_type;
+#endif
+
+#ifdef COMPACT_CELLS
+    // compact cells: the values are
+    // stored in narrow types, 16 bytes
+    // per record (see plugin defines),
+    // and written as the wide ones
+    typedef uint32_t
+        cell_count_type;
+
+    typedef int8_t
+        cell_ck_type;
+
+    typedef float
+        cell_dpf_type;
+
+    typedef int16_t
+        cell_dpg_type;
+#else
+    typedef count_type
+        cell_count_type;
+
+    typedef integral_noise_type
+        cell_ck_type;
+
+    typedef real_noise_type
+        cell_dpf_type;
+
+    typedef integral_noise_type
+        cell_dpg_type;
+#endif
+
+    /// @brief convert a value to the
+    /// type stored in the cells, clamped
+    /// to the range of narrow integers.
+    template <class _DstTy, class _SrcTy>
+    inline auto cell_value(
+        const _SrcTy& _Val)
+        ->_DstTy
+    {
+        typedef std::numeric_limits<
+            _DstTy> limits_type;
+
+        if (limits_type::is_integer)
+        {
+            if (_Val<limits_type::min())
+                return limits_type::min();
+
+            if (_Val>limits_type::max())
+                return limits_type::max();
+        }
+
+        return static_cast<_DstTy>(_Val);
+    }
+
+#ifndef MECHANISMS
+    // the mechanisms compiled in, 
+    // all unless configured (see
+    // plugin defines)
+#define MECHANISMS MECH_ALL
+#endif
+
+    /// @brief test whether a mechanism
+    /// is compiled in.
+    template <size_t _Mech>
+    struct mechanism
+    {
+        static const bool value=
+            (MECHANISMS & _Mech)!=0;
+    };
+
+    /// @brief column of a mechanism not
+    /// compiled in: empty, it takes no
+    /// room in the records, discards 
+    /// the values assigned and reads 0.
+    struct no_noise
+    {
+        template <class _Ty>
+        auto operator = (
+            const _Ty&)
+            ->no_noise&
+        {
+            return *this;
+        }
+
+        operator integral_noise_type() 
+            const
+        {
+            return 0;
+        }
+    };
+
+    /// @brief type of the column of a
+    /// mechanism, no_noise if not 
+    /// compiled in.
+    template <size_t _Mech, class _Ty>
+    struct noise_column
+    {
+        typedef typename std::conditional<
+            mechanism<_Mech>::value,
+                _Ty, no_noise>::type
+            type;
+    };
+
     typedef std::tuple<
-        count_type,     // 0 Count
-        integral_noise_type, // 1 CK
-        real_noise_type, // 2 DPF
-        integral_noise_type // 3 DPG
+        cell_count_type, // 0 Count
+        noise_column<MECH_CK, 
+            cell_ck_type>::type,  // 1 CK
+        noise_column<MECH_DPF, 
+            cell_dpf_type>::type, // 2 DPF
+        noise_column<MECH_DPG, 
+            cell_dpg_type>::type  // 3 DPG
+#ifdef MAGNITUDE
+        , magnitude_type, // 4 Sum
+        noise_column<MECH_CK, real_noise_type>
+            ::type, // 5 CK on Sum
+        noise_column<MECH_DPF, real_noise_type>
+            ::type, // 6 DPF on Sum
+        noise_column<MECH_DPG, real_noise_type>
+            ::type // 7 DPG on Sum
+#endif
         > 
         response_record_type;
 
+    /// @brief contribution of a sampled
+    /// record to the cells it falls in.
+    struct record_contrib
+    {
+        /// @brief record key
+        recordkey_sum_type
+            _Key;
+#ifdef MAGNITUDE
+        /// @brief value of the 
+        /// magnitude field
+        magnitude_type
+            _Val;
+#endif
+    };
+
+    /// @brief get the contribution of
+    /// a microdata record.
+    /// @param _Tup the record, whose
+    /// field 0 is the record key.
+    template <class _TupleTy>
+    inline auto make_contrib(
+        const _TupleTy& _Tup)
+        ->record_contrib
+    {
+        record_contrib _C;
+
+        _C._Key=std::get<0>(_Tup);
+#ifdef MAGNITUDE
+        _C._Val=static_cast<
+            magnitude_type>(std::get<
+                MAGNITUDE>(_Tup));
+#endif
+        return _C;
+    }
+
+
+    /// @brief number of DP values drawn
+    /// at once when none is left (see
+    /// response::next_laplace()).
+    static const size_t
+        _NoiseBatch(256);
+
+    /// @brief the DP noise of a cube, 
+    /// one stream for each mechanism.
+    /// @note the values are drawn in
+    /// advance, while the cube is 
+    /// aggregated (see response::
+    /// draw_noise()), then in batches
+    /// as the cells are finalized: the
+    /// stream continues where the 
+    /// values drawn in advance stop, so
+    /// the noise of each cell does not
+    /// depend on how many there are.
+    struct noise_buffer
+    {
+        std::vector<laplace_value_type>
+            _Lap;
+        std::vector<geometric_value_type>
+            _Geo;
+        size_t
+            _LPos;
+        size_t
+            _GPos;
+        stream_engine
+            _LEng;
+        stream_engine
+            _GEng;
+    };
+
+    /// @brief noise of the cube written
+    /// by each thread (see response::
+    /// use_noise()).
+    extern noise_buffer*
+        _Noise;
+    #pragma omp threadprivate(_Noise)
 
     /// @brief hypercube leaf at 
     /// arbitrary coordinates.
@@ -53,6 +272,11 @@ namespace confly
     /// - cell-key's bounded noise, 
     /// - differential privacy as vanilla Laplace,
     /// - differential privacy as geometric.
+    /// @note when built with MAGNITUDE,
+    /// sums up the magnitude field as well,
+    /// tracking the largest contribution 
+    /// in absolute value, which scales the
+    /// noise added to the sum.
     /// @note access to static objects
     /// ptable, Laplace distribution and
     /// geometric distribution
@@ -64,34 +288,100 @@ namespace confly
 
         /// @brief construct empty
         response()
-            : _Rkey(0.0)
+            : _Rkey(0)
             , _Rec()
+            , _Final(0)
+#ifdef MAGNITUDE
+            , _Max(0)
+#endif
         {
         }
 
         /// @brief increment the count,
-        /// sum up the supplied cell-key
-        /// @param _Key cell key
+        /// sum up the supplied record key
+        /// (and magnitude).
+        /// @param _C record key as drawn
+        /// by the random engine (and value
+        /// of the magnitude field).
+        /// @note record keys are summed as
+        /// integers, so that the cell key
+        /// does not depend on the order of
+        /// the updates (see merge()).
+        /// @note the noise of an updated
+        /// cell is drawn again (see 
+        /// read_state()).
         void update(
-            const cellkey_key_type& _Key)
+            const record_contrib& _C)
         {// update count and record key
+            _Final=0;
+
             ++std::get<0>(_Rec);
 
-            _Rkey+=_Key;
+            _Rkey+=_C._Key;
+#ifdef MAGNITUDE
+            std::get<4>(_Rec)+=_C._Val;
+
+            _Max=std::max(_Max, _C._Val<0 ?
+                -_C._Val : _C._Val);
+#endif
         }
 
-        /// @brief finalize cell-key (ptable
+        /// @brief sum up the count and the
+        /// record keys of a partial response
+        /// aggregated at the same coordinates.
+        /// @param _Right the partial response.
+        void merge(
+            const response& _Right)
+        {// merge partial aggregates
+            _Final=0;
+
+            std::get<0>(_Rec)+=
+                std::get<0>(_Right._Rec);
+
+            _Rkey+=_Right._Rkey;
+#ifdef MAGNITUDE
+            std::get<4>(_Rec)+=
+                std::get<4>(_Right._Rec);
+
+            _Max=std::max(_Max, 
+                _Right._Max);
+#endif
+        }
+
+        /// @brief finalize the requested
+        /// mechanisms: cell-key (ptable
         /// lookup) and differential privacy
         /// (draw noise from Laplace and 
         /// Geometric).
-        void finalize()
+        /// @param _Mech bit mask of the
+        /// mechanisms (MECH_CK, MECH_DPF,
+        /// MECH_DPG), usually demand().
+        /// @note the noise of a mechanism
+        /// is drawn on its first request 
+        /// only, so that the marginals
+        /// shared by several tables are 
+        /// published with the same noise;
+        /// the noise of the mechanisms
+        /// never requested is left zero.
+        void finalize(
+            const size_t& _Mech)
         {// finalize CK and DP
             // called by
             // iterate_write_cube
+            const size_t _Todo(
+                _Mech & ~_Final);
 
-            noise_ck_finalize();
+            if (! _Todo)
+                return;
 
-            noise_dp_finalize();
+            if (_Todo & MECH_CK)
+                noise_ck_finalize();
+
+            noise_dp_finalize(_Todo);
+#ifdef MAGNITUDE
+            noise_magnitude_finalize(_Todo);
+#endif
+            _Final|=_Todo;
         }
 
         /// @brief write count, CK noise,
@@ -99,6 +389,9 @@ namespace confly
         /// @param _S the output stream.
         /// @param _Sep the character used
         /// to separate the values.
+        /// @note the columns of the 
+        /// mechanisms not compiled in are
+        /// not written.
         void write(
             std::ostream& _S,
             char _Sep) 
@@ -106,11 +399,40 @@ namespace confly
         {// write data
             // called by
             // iterate_write_cube
-            _S 
-            << std::get<0>(_Rec) << _Sep
-            << std::get<1>(_Rec) << _Sep
-            << std::get<2>(_Rec) << _Sep
-            << std::get<3>(_Rec);
+            _S << (count_type)std::get<0>(_Rec);
+
+            if (mechanism<MECH_CK>::value)
+                _S << _Sep << (integral_noise_type)
+                    std::get<1>(_Rec);
+
+            if (mechanism<MECH_DPF>::value)
+                _S << _Sep << (real_noise_type)
+                    std::get<2>(_Rec);
+
+            if (mechanism<MECH_DPG>::value)
+                _S << _Sep << (integral_noise_type)
+                    std::get<3>(_Rec);
+#ifdef MAGNITUDE
+            const std::streamsize _Prec(
+                _S.precision(std::numeric_limits<
+                    real_noise_type>::digits10));
+
+            _S << _Sep << std::get<4>(_Rec);
+
+            if (mechanism<MECH_CK>::value)
+                _S << _Sep << (real_noise_type)
+                    std::get<5>(_Rec);
+
+            if (mechanism<MECH_DPF>::value)
+                _S << _Sep << (real_noise_type)
+                    std::get<6>(_Rec);
+
+            if (mechanism<MECH_DPG>::value)
+                _S << _Sep << (real_noise_type)
+                    std::get<7>(_Rec);
+
+            _S.precision(_Prec);
+#endif
         }
 
         /// @brief read count, CK noise, 
@@ -120,11 +442,99 @@ namespace confly
         bool read(
             std::istream& _S)
         {
-            _S
-            >> std::get<0>(_Rec)
-            >> std::get<1>(_Rec)
-            >> std::get<2>(_Rec)
-            >> std::get<3>(_Rec);
+            // read as the wide types
+            count_type _Count(0);
+            integral_noise_type _CK(0), _DPG(0);
+            real_noise_type _DPF(0);
+
+            _S >> _Count;
+
+            if (mechanism<MECH_CK>::value)
+                _S >> _CK;
+
+            if (mechanism<MECH_DPF>::value)
+                _S >> _DPF;
+
+            if (mechanism<MECH_DPG>::value)
+                _S >> _DPG;
+
+            std::get<0>(_Rec)=
+                cell_value<cell_count_type>(_Count);
+            std::get<1>(_Rec)=
+                cell_value<cell_ck_type>(_CK);
+            std::get<2>(_Rec)=
+                cell_value<cell_dpf_type>(_DPF);
+            std::get<3>(_Rec)=
+                cell_value<cell_dpg_type>(_DPG);
+#ifdef MAGNITUDE
+            real_noise_type 
+                _MCK(0), _MDPF(0), _MDPG(0);
+
+            _S >> std::get<4>(_Rec);
+
+            if (mechanism<MECH_CK>::value)
+                _S >> _MCK;
+
+            if (mechanism<MECH_DPF>::value)
+                _S >> _MDPF;
+
+            if (mechanism<MECH_DPG>::value)
+                _S >> _MDPG;
+
+            std::get<5>(_Rec)=_MCK;
+            std::get<6>(_Rec)=_MDPF;
+            std::get<7>(_Rec)=_MDPG;
+#endif
+            return true;
+        }
+
+        /// @brief write the raw state of 
+        /// the cell (record key sum and
+        /// largest magnitude contribution)
+        /// followed by the record.
+        /// @param _S the output stream.
+        /// @param _Sep the character used
+        /// to separate the values.
+        /// @note written after finalize(),
+        /// the state keeps the noise of the
+        /// cell as well (see read_state()).
+        void write_state(
+            std::ostream& _S,
+            char _Sep) 
+            const 
+        {
+            _S << _Rkey << _Sep;
+#ifdef MAGNITUDE
+            const std::streamsize _Prec(
+                _S.precision(std::numeric_limits<
+                    real_noise_type>::digits10));
+
+            _S << _Max << _Sep;
+
+            _S.precision(_Prec);
+#endif
+            write(_S, _Sep);
+        }
+
+        /// @brief read the state written
+        /// by write_state().
+        /// @param _S the input stream.
+        /// @note the cell is finalized, i.e.
+        /// it keeps its noise unless updated
+        /// again (delta aggregation); the
+        /// state is expected to be written
+        /// with the same mechanisms.
+        bool read_state(
+            std::istream& _S)
+        {
+            _S >> _Rkey;
+#ifdef MAGNITUDE
+            _S >> _Max;
+#endif
+            if (! read(_S) || _S.fail())
+                return false;
+
+            _Final=_Demand;
 
             return true;
         }
@@ -160,6 +570,106 @@ namespace confly
                 0, _DPGeps);
         }
 
+        /// @brief import the mechanisms
+        /// requested by the writers.
+        /// @param _Mech bit mask of the
+        /// mechanisms (MECH_ALL by default).
+        static void set_demand(
+            const size_t& _Mech)
+        {
+            _Demand=_Mech & MECHANISMS;
+        }
+
+        /// @brief get the mechanisms
+        /// requested by the writers.
+        static auto demand()
+            ->const size_t&
+        {
+            return _Demand;
+        }
+
+        /// @brief start the noise streams
+        /// of a cube.
+        /// @param _Buf the noise buffer.
+        /// @param _Seed the seed.
+        /// @param _Cube the ordinal of
+        /// the cube.
+        static void reset_noise(
+            noise_buffer& _Buf,
+            const uint64_t& _Seed,
+            const uint64_t& _Cube)
+        {
+            _Buf._LEng.seed(_Seed, _Cube,
+                STREAM_DPF);
+            _Buf._GEng.seed(_Seed, _Cube,
+                STREAM_DPG);
+
+            _Buf._Lap.clear();
+            _Buf._Geo.clear();
+            _Buf._LPos=_Buf._GPos=0;
+        }
+
+        /// @brief draw in advance the noise
+        /// of the mechanisms requested (see
+        /// demand()) for _N cells.
+        /// @param _Buf the noise buffer.
+        /// @param _N number of values of
+        /// each mechanism.
+        /// @note called by any thread, as
+        /// long as the buffer is not used
+        /// by the writer yet.
+        static void draw_noise(
+            noise_buffer& _Buf,
+            const size_t& _N)
+        {
+            if (mechanism<MECH_DPF>::value &&
+                (_Demand & MECH_DPF))
+                append(_Laplace, _Buf._LEng,
+                    _Buf._Lap, _N);
+
+            if (mechanism<MECH_DPG>::value &&
+                (_Demand & MECH_DPG))
+                append(_Geometric, _Buf._GEng,
+                    _Buf._Geo, _N);
+        }
+
+        /// @brief get the number of values
+        /// of each DP mechanism requested 
+        /// (see demand()) finalizing a cell
+        /// takes: 0 if none is requested.
+        static auto noise_per_cell()
+            ->size_t
+        {
+            const bool _BDP(
+                (mechanism<MECH_DPF>::value &&
+                    (_Demand & MECH_DPF)) ||
+                (mechanism<MECH_DPG>::value &&
+                    (_Demand & MECH_DPG)));
+#ifdef MAGNITUDE
+            return _BDP ? 2 : 0;
+#else
+            return _BDP ? 1 : 0;
+#endif
+        }
+
+        /// @brief finalize the cells written
+        /// by this thread with the noise of
+        /// the buffer.
+        /// @param _Buf the noise buffer.
+        static void use_noise(
+            noise_buffer& _Buf)
+        {
+            _Noise=&_Buf;
+        }
+
+        /// @brief detach the buffer from
+        /// the cells written by this 
+        /// thread, once the cube is done.
+        static void release_noise()
+        {
+            _Noise=0;
+        }
+
         /// @brief import ptable. 
         /// @param _Ptab precomputed ptable.
         static void set_ptable(
@@ -170,19 +680,44 @@ namespace confly
 
     private:
 
+		auto cell_key() const
+			->cellkey_key_type
+		{
+#ifdef FIXED_RKEY
+			// the sum of the record keys
+			// wraps around 2^32, i.e. it
+			// is the fractional part of 
+			// the sum of the keys scaled
+			// by 2^32: exact, whatever the
+			// order of the sums
+			return (cellkey_key_type)
+				_Rkey/4294967296.0;
+#else
+			// find cell key as the
+			// fractional part of the
+			// sum of the record keys
+			// (each one scaled by the
+			// engine's max)
+			static const recordkey_sum_type
+				_DREMAX(engine_max());
+
+			return (cellkey_key_type)
+                (_Rkey%_DREMAX)/
+                    _DREMAX;
+#endif
+		}
+
 		void noise_ck_finalize()
 		{
-			// find cell key
-			cellkey_key_type
-                 _CellKey=
-                ::fmod(_Rkey, 1.0);;
+			const cellkey_key_type
+                 _CellKey(cell_key());
 
 			// lookup ptable
 			// CK noise
-            std::get<1>(_Rec)=
-                _PTable.lookup(
+            std::get<1>(_Rec)=cell_value<
+                cell_ck_type>(_PTable.lookup(
                     std::get<0>(_Rec), // count
-                        _CellKey);
+                        _CellKey));
 
             #if (BDEBUG)
 			debug_msg<4>(
@@ -193,27 +728,116 @@ namespace confly
             #endif
 		}
 
-		void noise_dp_finalize()
+		template <class _DistTy, class _ValTy>
+		static void append(
+			_DistTy& _Dist,
+			stream_engine& _RE,
+			std::vector<_ValTy>& _Vals,
+			const size_t& _N)
+		{// the next _N values of 
+			// the stream
+			const size_t _Sz(_Vals.size());
+
+			if (0==_N)
+				return;
+
+			_Vals.resize(_Sz+_N);
+
+			_Dist.fill(_RE, &_Vals[_Sz],
+				_N);
+		}
+
+		static auto next_laplace()
+			->laplace_value_type
+		{// drawn in advance, or
+			// in batches
+			noise_buffer& _Buf(*_Noise);
+
+			if (_Buf._LPos==_Buf._Lap.size())
+				append(_Laplace, _Buf._LEng,
+					_Buf._Lap, _NoiseBatch);
+
+			return _Buf._Lap[_Buf._LPos++];
+		}
+
+		static auto next_geometric()
+			->geometric_value_type
+		{// drawn in advance, or
+			// in batches
+			noise_buffer& _Buf(*_Noise);
+
+			if (_Buf._GPos==_Buf._Geo.size())
+				append(_Geometric, _Buf._GEng,
+					_Buf._Geo, _NoiseBatch);
+
+			return _Buf._Geo[_Buf._GPos++];
+		}
+
+		void noise_dp_finalize(
+			const size_t& _Todo)
 		{
             // DPF
-            std::get<2>(_Rec)
-                =_Laplace(_DRE);
+            if (_Todo & MECH_DPF)
+            std::get<2>(_Rec)=cell_value<
+                cell_dpf_type>(next_laplace());
 
             // DPG
-            std::get<3>(_Rec)
-                =_Geometric(_DRE);
+            if (_Todo & MECH_DPG)
+            std::get<3>(_Rec)=cell_value<
+                cell_dpg_type>(next_geometric());
+		}
+
+#ifdef MAGNITUDE
+		void noise_magnitude_finalize(
+			const size_t& _Todo)
+		{
+			// CK: the noise drawn with
+			// the same cell key from the
+			// symmetric row of the ptable
+			// (the last one), as a share
+			// of the largest contribution
+			// (the ptable is imported
+			// before the first cube)
+			static const ptable::integer_type
+				_D(_PTable.get_bound());
+
+			if (_Todo & MECH_CK)
+			std::get<5>(_Rec)= 0==_D ? 0 :
+				(real_noise_type)_PTable
+				.lookup(_PTable.get_ncat(),
+					cell_key())/_D*_Max;
+
+			// DPF and DPG: sensitivity
+			// of the sum taken as the
+			// largest contribution
+			if (_Todo & MECH_DPF)
+			std::get<6>(_Rec)
+				=next_laplace()*_Max;
+
+			if (_Todo & MECH_DPG)
+			std::get<7>(_Rec)
+				=next_geometric()*(real_noise_type)_Max;
 		}
+#endif
 
-        cellkey_key_type
+        recordkey_sum_type
             _Rkey;
         record_type
             _Rec;
+        unsigned char
+            _Final; // mechanisms drawn
+#ifdef MAGNITUDE
+        magnitude_type
+            _Max;
+#endif
         static laplace_distribution
             _Laplace;
         static geometric_distribution
             _Geometric;
         static ptable
             _PTable;
+        static size_t
+            _Demand;
     };
 
     /// @brief structure to hold
@@ -252,6 +876,8 @@ namespace confly
             const size_t& _ID,
             const record_type& _Rec)
         {
+            assert(_ID<_Cont.size());
+
             _Cont[_ID]=_Rec;
         }
 
@@ -270,6 +896,8 @@ namespace confly
         /// - perturbed count using noise cellkey
         /// - perturbed count using noise DP Laplace
         /// - perturbed count using noise DP Geometric
+        /// followed, when built with MAGNITUDE, by
+        /// the same values for the sum.
         void write(
             std::ostream& _S,
             char _Sep)
@@ -281,18 +909,72 @@ namespace confly
                 const record_type&
                     _R(_Cont[i]);
 
-                _S 
-                << std::get<0>(_R) << _Sep // count
-                << std::get<1>(_R) << _Sep // naked CK
-                << std::get<2>(_R) << _Sep // naked DPF
-                << std::get<3>(_R) << _Sep // naked DPG
-                << std::get<0>(_R)
-                    + std::get<1>(_R) << _Sep // CK
-                << std::get<0>(_R)
-                    + std::get<2>(_R) << _Sep // DPF
-                << std::get<0>(_R)
-                    + std::get<3>(_R) // DPG
-                << CHARNL;
+                // as the wide types
+                const count_type 
+                    _Count(std::get<0>(_R));
+                const integral_noise_type 
+                    _CK(std::get<1>(_R)),
+                    _DPG(std::get<3>(_R));
+                const real_noise_type 
+                    _DPF(std::get<2>(_R));
+
+                // the naked noises, then
+                // the perturbed counts, of
+                // the mechanisms compiled in
+                _S << _Count;
+
+                if (mechanism<MECH_CK>::value)
+                    _S << _Sep << _CK;
+
+                if (mechanism<MECH_DPF>::value)
+                    _S << _Sep << _DPF;
+
+                if (mechanism<MECH_DPG>::value)
+                    _S << _Sep << _DPG;
+
+                if (mechanism<MECH_CK>::value)
+                    _S << _Sep << _Count+_CK;
+
+                if (mechanism<MECH_DPF>::value)
+                    _S << _Sep << _Count+_DPF;
+
+                if (mechanism<MECH_DPG>::value)
+                    _S << _Sep << _Count+_DPG;
+#ifdef MAGNITUDE
+                const std::streamsize _Prec(
+                    _S.precision(std::numeric_limits<
+                        real_noise_type>::digits10));
+
+                const magnitude_type 
+                    _Sum(std::get<4>(_R));
+                const real_noise_type
+                    _MCK(std::get<5>(_R)),
+                    _MDPF(std::get<6>(_R)),
+                    _MDPG(std::get<7>(_R));
+
+                _S << _Sep << _Sum; // sum
+
+                if (mechanism<MECH_CK>::value)
+                    _S << _Sep << _MCK;
+
+                if (mechanism<MECH_DPF>::value)
+                    _S << _Sep << _MDPF;
+
+                if (mechanism<MECH_DPG>::value)
+                    _S << _Sep << _MDPG;
+
+                if (mechanism<MECH_CK>::value)
+                    _S << _Sep << _Sum+_MCK;
+
+                if (mechanism<MECH_DPF>::value)
+                    _S << _Sep << _Sum+_MDPF;
+
+                if (mechanism<MECH_DPG>::value)
+                    _S << _Sep << _Sum+_MDPG;
+
+                _S.precision(_Prec);
+#endif
+                _S << CHARNL;
             }
         }
 
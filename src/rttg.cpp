@@ -1,5 +1,9 @@
-#include "rttg.hpp"
+// the plugin defines come first,
+// as the headers are specialized
+// on them (e.g. MAGNITUDE)
 #include "rttg_types.hpp"
+#include "rttg.hpp"
+#include <thread>
 
 namespace confly
 {
@@ -9,13 +13,40 @@ namespace confly
 	typedef hypercube<PARAMS>
 		hypercube_type;
 
+#ifdef SHAPE
+	// compile-time shape of the
+	// flat cubes, as observed in
+	// the data (see plugin::create)
+	typedef fixed_shape<SHAPE>
+		shape_type;
+#else
+	typedef cell_layout
+		shape_type;
+#endif
+
     // -----------------------------------------
     // allocate/hold singletons
 
-    // prng instance
+    // prng instance, drawing the
+    // record keys
     mersenne_twister
         _DRE;
 
+    // seed of the streams of
+    // the cubes
+    uint64_t
+        _StreamSeed(0);
+
+    // threads aggregating
+    // each single cube
+    size_t
+        _Threads(1);
+
+    // radix-partitioned aggregation
+    // on flat cubes
+    bool
+        _BRadix(false);
+
     // differential privacy
     double 
         _DPFmu(0.0),
@@ -29,6 +60,13 @@ namespace confly
         response::_Geometric(0.0, 0.0);
     ptable 
         response::_PTable;
+    size_t
+        response::_Demand(MECHANISMS);
+
+    // noise of the cube written,
+    // per thread
+    noise_buffer*
+        _Noise(0);
 
     // static traversed_response members
     size_t 
@@ -41,6 +79,44 @@ namespace confly
             ::traversing_nested_map_type
         hypercube<_Types...>::_Trv;
 
+    // the thread drawing the noise of
+    // a cube in advance: joined, and
+    // the noise of the writer thread
+    // released, once the cube is done,
+    // also when the cube throws
+    struct noise_producer
+    {
+        noise_producer(
+            noise_buffer& _Buf,
+            const size_t& _Ahead)
+            : _Thread()
+        {
+            if (_Ahead>0)
+                _Thread=std::thread(
+                    &response::draw_noise,
+                        std::ref(_Buf),
+                            _Ahead);
+        }
+
+        ~ noise_producer()
+        {
+            join();
+
+            response::release_noise();
+        }
+
+        void join()
+        {
+            if (_Thread.joinable())
+                _Thread.join();
+        }
+
+    private:
+
+        std::thread
+            _Thread;
+    };
+
     // -----------------------------------------
     // implement plugin functions
 
@@ -74,10 +150,33 @@ namespace confly
             ::_MaxSz=_Sz;
     }
 
+    void import_threads(
+        const size_t& _cThreads)
+    {// import threads per cube
+        _Threads=std::max<size_t>(
+            1, _cThreads);
+    }
+
+    void import_radix(
+        const bool& _cBRadix)
+    {// import aggregation mode
+        _BRadix=_cBRadix;
+    }
+
+    void import_mechanisms(
+        const size_t& _cMech)
+    {// import the mechanisms
+        // to finalize and write
+        response::set_demand(
+            _cMech);
+    }
+
     void seed_prng(
         const size_t& _Seed)
     {
         _DRE.seed(_Seed);
+
+        _StreamSeed=_Seed;
     }
 
 
@@ -148,9 +247,31 @@ namespace confly
         const auto& _Meta(
             _CastMicro->get_meta());
 
-        // get mask
-        const auto& _Mask(
-            _CastMicro->get_mask());
+        // get the lattice of marginals,
+        // union of the tables' ones
+        const auto& _Lattice(
+            _CastMicro->get_lattice());
+
+        // get the tables to write
+        const auto& _Tables(
+            _CastMicro->get_tables());
+
+        const auto& _TLattices(
+            _CastMicro->get_table_lattices());
+
+#ifdef COMPACT_CELLS
+        if (_Vec.size()>std::numeric_limits<
+            cell_count_type>::max())
+        {// counts of compact cells
+            // may overflow
+            flush_msg(std::cout,
+                M_ERROR,
+                M_CELLS,
+                M_CUMBER);
+
+            return false;
+        }
+#endif
 
         // get sample size
         const size_t 
@@ -159,30 +280,114 @@ namespace confly
                 static_cast<double>(
                 _RecordsSz)*_Rate));
 
-        // hold indeces here
-        std::set<size_t> 
-            _Indeces;
+        // flag sampled records here
+        std::vector<bool> 
+            _Marks;
+
+        if (_CastMicro->is_keyed())
+        {// reproducible Bernoulli
+            // sample of each record
+            _CastMicro->mark(_CastCube
+                ->get_ordinal(), _Rate, _Marks);
+        }
 
-        // draw _SampleSz vector indeces
-        // between 0 and vector.size-1
-        unif<size_t> _Unif; _Unif
-            .draw(0, _RecordsSz-1, 
-                _SampleSz, _Indeces); 
+        else
+        {// draw _SampleSz vector indeces
+            // between 0 and vector.size-1,
+            // from the stream of the cube
+            stream_engine _Eng; _Eng.seed(
+                _StreamSeed, _CastCube
+                    ->get_ordinal(), STREAM_SAMPLE);
+
+            unif<size_t> _Unif; _Unif
+                .mark(0, _RecordsSz-1, 
+                    _SampleSz, _Marks, _Eng); 
+        }
 
-        debug_msg<3>(_Indeces.size());
+        // get the layout of flat cubes,
+        // empty unless micro encoded
+        const auto& _Layout(
+            _CastMicro->get_layout());
 
-        // aggregate hypercube
-        for (auto I=_Indeces.cbegin(),
-            E=_Indeces.cend(); I!=E; 
-                ++I)
+        if (_BRadix && 0==_Layout.size())
         {
-            _CastCube->update(
-                _Mask, _Vec[*I]);
+            flush_msg(std::cout,
+                M_ERROR,
+                M_UNINITIALIZED,
+                M_CELLS);
+
+            return false;
         }
 
-        // finalize/write cube
-        std::ofstream 
-            _Fout(_Fname);
+#ifdef SHAPE
+        const shape_type _Shape;
+
+        if (_BRadix && ! _Shape
+            .matches(_Layout))
+        {// data changed since
+            // the plugin was built
+            flush_msg(std::cout,
+                M_ERROR,
+                M_CELLS,
+                M_MISMATCH);
+
+            return false;
+        }
+#else
+        const shape_type& _Shape(
+            _Layout);
+#endif
+
+        // noise drawn afresh for each
+        // cube, from its streams: as
+        // much as the cells written
+        // need, known from the data, is
+        // drawn in advance by another
+        // thread, while the cube is
+        // aggregated
+        noise_buffer _NoiseBuf;
+
+        response::reset_noise(_NoiseBuf,
+            _StreamSeed, _CastCube
+                ->get_ordinal());
+
+        const size_t _Ahead(response
+            ::noise_per_cell()*(
+            _CastMicro->is_sparse() ?
+            _CastMicro->get_support()
+                .size() :
+            hypercube_type::cells(
+                _Meta, _Lattice)));
+
+        noise_producer _Producer(
+            _NoiseBuf, _Ahead);
+
+        // aggregate hypercube, splitting
+        // the records among _Threads
+        if (_BRadix)
+        _CastCube->update(
+            _Layout, _Shape, 
+                _CastMicro->get_codes(),
+                    _Lattice, _Marks, 
+                        _Threads);
+
+        else
+        _CastCube->update(
+            _Lattice, _Vec, _Marks,
+                _Threads, _CastMicro
+                    ->get_starts());
+
+        // the levels of the hierarchies
+        // above the leaves
+        if (! _BRadix && _CastMicro
+            ->has_hierarchies())
+        _CastCube->roll_up(
+            _CastMicro->get_ancestry());
+
+        _Producer.join();
+
+        response::use_noise(
+            _NoiseBuf);
 
         // interpret traversing size
         // equal to zero as "--no-traverse"
@@ -191,9 +396,35 @@ namespace confly
             traversed_response
             ::_MaxSz==0);
 
-        _CastCube->write(
-            _Meta, _Fout,
-            _BNoTrav);
+        for (size_t t=0; t<_Tables.size();
+            ++t)
+        {// finalize/write cube, one
+            // file per table; the cells
+            // shared by several tables
+            // are finalized once
+            std::ofstream 
+                _Fout(table_fname(_Fname,
+                    _Tables[t]._Name));
+
+            if (_BRadix)
+            _CastCube->write(
+                _Meta, _Shape, _TLattices[t], 
+                _Fout, _BNoTrav);
+
+            else if (_CastMicro->is_sparse())
+            _CastCube->write(
+                _CastMicro->get_support(),
+                _TLattices[t], _Fout, 
+                _BNoTrav);
+
+            else
+            _CastCube->write(
+                _Meta, _TLattices[t], 
+                _Fout, _BNoTrav);
+        }
+
+        if (_BRadix)
+        _CastCube->release();
 
         return true;
     }
@@ -224,9 +455,29 @@ namespace confly
         const auto& _Meta(
             _CastMicro->get_meta());
 
-        hypercube_type
-            ::write_traversing(
-            _Meta, _cPath);
+        // get the tables to write
+        const auto& _Tables(
+            _CastMicro->get_tables());
+
+        const auto& _TLattices(
+            _CastMicro->get_table_lattices());
+
+        for (size_t t=0; t<_Tables.size();
+            ++t)
+        {
+            if (_CastMicro->is_sparse())
+            hypercube_type // cells written
+                ::write_traversing(
+                _TLattices[t], _cPath, 
+                    _Tables[t]._Name);
+
+            else
+            hypercube_type
+                ::write_traversing(
+                _Meta, _TLattices[t],
+                    _cPath, _Tables[t]
+                        ._Name);
+        }
 
         return true;
     }
@@ -18,6 +18,15 @@ namespace confly
     void import_size(
         const size_t& _Sz);
 
+    void import_threads(
+        const size_t& _cThreads);
+
+    void import_radix(
+        const bool& _cBRadix);
+
+    void import_mechanisms(
+        const size_t& _cMech);
+
     void seed_prng(
         const size_t& _Seed);
 
@@ -290,6 +290,29 @@ inline auto path_ext(
         .rfind('.'));
 }
 
+inline auto table_fname(
+    const std::string& _Path,
+    const std::string& _Name)
+    -> std::string
+{// path/cube_0.csv -> path/cube_name_0.csv
+    if (_Name.empty())
+        return _Path;
+
+    const size_t _Dir(
+        _Path.rfind('/'));
+
+    const size_t _Pos(_Path.find('_',
+        std::string::npos==_Dir ? 
+            0 : _Dir+1));
+
+    if (std::string::npos==_Pos)
+        return _Path;
+
+    return _Path.substr(0, _Pos+1)
+        + _Name + '_' 
+        + _Path.substr(_Pos+1);
+}
+
 // ----------------------------------------------
 // mem utils
 
@@ -335,6 +335,71 @@ namespace confly
 
     // -------------------------------------
 
+    /// @brief given a unsigned long mask,
+    /// compare two tuples lexicographically,
+    /// skipping the masked positions.
+    template <
+        size_t I, size_t M>
+    struct conditional_compare_tuple
+    {
+        /// @brief compare the Ith elements
+        /// unless masked, then recurr.
+        /// @param _P mask of the positions
+        /// to skip.
+        /// @param _Left the left tuple.
+        /// @param _Right the right tuple.
+        /// @return negative if left comes
+        /// first, positive if right comes
+        /// first, zero if equal.
+        /// @warning to be used only starting
+        /// from tuple index 1 (not zero).
+        template <
+            class _TupleTy>
+        static int compare(
+            const size_t& _P,
+            const _TupleTy& _Left,
+            const _TupleTy& _Right)
+        {
+            if (! (_P & (size_t)1<<(I-1)))
+            {// not masked
+                if (std::get<I>(_Left)<
+                    std::get<I>(_Right))
+                    return -1;
+
+                if (std::get<I>(_Right)<
+                    std::get<I>(_Left))
+                    return 1;
+            }
+
+            // recurr
+            return conditional_compare_tuple<
+                I+1, M>::compare(_P, 
+                    _Left, _Right);
+        }
+    };
+
+    /// @brief conditional_compare_tuple
+    /// stop recursion
+    template <
+        size_t I>
+    struct conditional_compare_tuple <I, I>
+    {
+        /// @brief conditional_compare_tuple
+        /// stop
+        /// @return zero (equal)
+        template <
+            class _TupleTy>
+        static int compare(
+            const size_t&,
+            const _TupleTy&,
+            const _TupleTy&)
+        {
+            return 0;
+        }
+    };
+
+    // -------------------------------------
+
     /// @brief copy insert tuple values into
     /// a tuple of containers, of the same 
     /// respective types, which implements